@@ -7,7 +7,9 @@
 #include <string>
 #include <cstring>
 #include <cassert>
+#include <cstdint>
 #include "Pool.h"
+#include "Dictionary.h"
 
 #if defined(ARDUINO)
 #include <Arduino.h>
@@ -23,6 +25,11 @@
 #define ARG_MASK_NUMBER        (ARG_MASK_REAL|ARG_MASK_INTEGER)
 #define ARG_MASK_ANY           (ARG_MASK_NUMBER|ARG_MASK_BOOLEAN|ARG_MASK_STRING)
 
+// number of arguments an Arguments collection holds without allocating
+#if !defined(RESTFULLY_INLINE_ARGUMENTS)
+#define RESTFULLY_INLINE_ARGUMENTS    4
+#endif
+
 
 namespace Rest {
 
@@ -31,7 +38,7 @@ namespace Rest {
     public:
         inline Type() : name_index(0), type_mask(0) {}
         Type(const char* _name, unsigned short _typemask)
-                : name_index(binbag_insert_distinct(literals_index, _name, strcasecmp)),
+                : name_index(binbag_insert_distinct(initLiteralsIndex(), _name, strcasecmp)),
                   type_mask(_typemask) {
         }
 
@@ -41,6 +48,7 @@ namespace Rest {
         }
 
         inline const char* name() const { return binbag_get(literals_index, name_index); }
+        inline long nameIndex() const { return name_index; }
 
         inline unsigned short typemask() const { return type_mask; }
         inline bool supports(unsigned short mask) const { return (mask & type_mask)==mask; }
@@ -54,44 +62,52 @@ namespace Rest {
         unsigned short type_mask;
     };
 
-    class Argument : protected Type {
+    /// \brief An interned argument name
+    /// Look the name up once, for example into a static, and use it to find arguments by comparing integer ids rather
+    /// than strings. Names are case insensitive, the same as in endpoint expressions.
+    class ArgumentName {
     public:
-        typedef Type Type;
-
-        using Type::name;
-
-        Argument() : type(0), ul(0) {}
-        Argument(const Argument& copy) : Type(copy), type(copy.type), ul(copy.ul) {
-            if(type == ARG_MASK_STRING)
-                s = strdup(copy.s);
-            else if((type & ARG_MASK_REAL) >0)
-                d = copy.d;
-            else
-                ul = copy.ul;
+        explicit ArgumentName(const char* _name) {
+            id = (uint32_t)binbag_insert_distinct(initLiteralsIndex(), _name, strcasecmp);
         }
 
-        Argument(const Type& arg) : Type(arg), type(0), ul(0) {}
-
-        Argument(const Type& arg, long _l) : Type(arg), type(ARG_MASK_INTEGER), l(_l) {}
-        Argument(const Type& arg, unsigned long _ul) : Type(arg), type(ARG_MASK_UINTEGER), ul(_ul) {}
-        Argument(const Type& arg, double _d) : Type(arg), type(ARG_MASK_NUMBER), d(_d) {}
-        Argument(const Type& arg, bool _b) : Type(arg), type(ARG_MASK_BOOLEAN), b(_b) {}
-        Argument(const Type& arg, const char* _s) : Type(arg), type(ARG_MASK_STRING), s(strdup(_s)) {}
-
-        virtual ~Argument() { if(s && type == ARG_MASK_STRING) ::free(s); }
-
-        Argument& operator=(const Argument& copy) {
-            Type::operator=(copy);
-            type = copy.type;
-            if(type == ARG_MASK_STRING)
-                s = strdup(copy.s);
-            else if((type & ARG_MASK_REAL) >0)
-                d = copy.d;
-            else
-                ul = copy.ul;
-            return *this;
+        inline const char* name() const { return binbag_get(literals_index, id); }
+
+        inline bool operator==(const ArgumentName& rhs) const { return id == rhs.id; }
+        inline bool operator!=(const ArgumentName& rhs) const { return id != rhs.id; }
+
+        uint32_t id;
+    };
+
+    /// \brief The value of an argument parsed from a Uri
+    /// Arguments are small, trivially copyable values so an array of them can be grown with memcpy. A string value is
+    /// a view of memory owned by the Arguments collection (or arena) the argument is stored in. Copying an Argument
+    /// does not copy the string, adding it to an Arguments collection does.
+    class Argument {
+    public:
+        typedef Rest::Type Type;
+
+        Argument() : name_id(0), type(0), len(0), ul(0) {}
+
+        Argument(const Type& arg) : name_id((uint32_t)arg.nameIndex()), type(0), len(0), ul(0) {}
+
+        Argument(const Type& arg, long _l) : name_id((uint32_t)arg.nameIndex()), type(ARG_MASK_INTEGER), len(0), l(_l) {}
+        Argument(const Type& arg, unsigned long _ul) : name_id((uint32_t)arg.nameIndex()), type(ARG_MASK_UINTEGER), len(0), ul(_ul) {}
+        Argument(const Type& arg, double _d) : name_id((uint32_t)arg.nameIndex()), type(ARG_MASK_NUMBER), len(0), d(_d) {}
+        Argument(const Type& arg, bool _b) : name_id((uint32_t)arg.nameIndex()), type(ARG_MASK_BOOLEAN), len(0), b(_b) {}
+
+        /// \brief A string argument viewing _s
+        /// The string must outlive the argument, or be added to an Arguments collection which takes a copy.
+        Argument(const Type& arg, const char* _s) : name_id((uint32_t)arg.nameIndex()), type(ARG_MASK_STRING), len(0), s((char*)_s) {
+            setLength(strlen(_s));
         }
 
+        inline const char* name() const { return binbag_get(literals_index, name_id); }
+        inline uint32_t nameId() const { return name_id; }
+
+        /// \brief length of a string value
+        inline size_t length() const { return (len < max_length) ? len : strlen(s); }
+
         bool operator==(const Argument& rhs) const {
             return (type == rhs.type) && (
                     (type==ARG_MASK_STRING && strcmp(s, rhs.s)==0) ||
@@ -153,15 +169,23 @@ namespace Rest {
         }
 #endif
 
+    protected:
+        // index of the argument name in the literals index
+        uint32_t name_id;
 
-#if 0   // ArgumentValues should never change, so use constructor only (and assignment op if needed)
-        void set(long _l) { type = ARG_MASK_INTEGER; l = _l; }
-        void set(unsigned long _ul) { type = ARG_MASK_UINTEGER; l = _ul; }
-        void set(bool _b) { type = ARG_MASK_BOOLEAN; b = _b; }
-        void set(const char* _s) { type = ARG_MASK_STRING; s = strdup(_s); }
-#endif
+        // strings this long or longer store max_length and are measured with strlen
+        static const unsigned short max_length = 0xffff;
+
+        inline void setLength(size_t n) { len = (n < max_length) ? (unsigned short)n : max_length; }
+
+    public:
         unsigned short type;
 
+    protected:
+        // length of a string value, see length()
+        unsigned short len;
+
+    public:
         union {
             long l;
             unsigned long ul;
@@ -172,56 +196,91 @@ namespace Rest {
 
     public:
         static const Argument null;
+
+        friend class Arguments;
     };
 
+    static_assert(sizeof(Argument) <= 16, "Argument should be a compact 16 byte value");
+
     class Arguments {
         using _size_t = short;
 
     public:
+        /// number of arguments held within the Arguments object itself before spilling to the heap (or arena)
+        static constexpr _size_t inline_capacity = RESTFULLY_INLINE_ARGUMENTS;
+
         Arguments()
-            : args(nullptr), _capacity(0), _count(0)
+            : args(inlined()), _capacity(inline_capacity), _count(0), _arena(nullptr)
+        {}
+
+        /// \brief Arguments allocated from a request arena
+        /// Arguments beyond the inline capacity and the string values are allocated from the arena rather than the
+        /// heap and are released all at once when the arena is reset, so the Arguments must not be used after that.
+        explicit Arguments(PagedPool& arena)
+            : args(inlined()), _capacity(inline_capacity), _count(0), _arena(&arena)
         {}
 
         Arguments(_size_t _capacity)
-            : args(nullptr), _capacity(0), _count(0)
+            : args(inlined()), _capacity(inline_capacity), _count(0), _arena(nullptr)
         {
-            alloc(_capacity);
+            reserve(_capacity);
         }
 
         Arguments(Argument* _args, _size_t n)
-                : args(nullptr), _capacity(0), _count(0)
+                : args(inlined()), _capacity(inline_capacity), _count(0), _arena(nullptr)
         {
             copy(_args, _args + n);
         }
 
         Arguments(Argument* _args, _size_t n, _size_t _capacity)
-                : args(nullptr), _capacity(0), _count(0)
+                : args(inlined()), _capacity(inline_capacity), _count(0), _arena(nullptr)
         {
-            if(_capacity<n) _capacity = n;
-            alloc(_capacity);
+            reserve(std::max(_capacity, n));
             copy(_args, _args + n);
         }
 
+        /// \brief Copy arguments
+        /// A copy uses the same arena as the original. Assigning arguments keeps the arena of the destination.
         Arguments(const Arguments& _copy)
-            : args(nullptr), _capacity(0), _count(0)
+            : args(inlined()), _capacity(inline_capacity), _count(0), _arena(_copy._arena)
         {
-            alloc(_copy._capacity);
             copy(_copy.args, _copy.args + _copy._count);
         }
 
+        /// \brief Move arguments
+        /// Heap or arena memory is taken over by the new Arguments, inline arguments are moved without copying their
+        /// strings.
+        Arguments(Arguments&& _move) noexcept
+            : args(inlined()), _capacity(inline_capacity), _count(0), _arena(_move._arena)
+        {
+            take(_move);
+        }
+
         virtual ~Arguments() { free(); }
 
         inline Arguments& operator=(const Arguments& _copy) {
-            free();
-            alloc(_copy._capacity);
+            if(this == &_copy)
+                return *this;
+            clear();
             copy(_copy.args, _copy.args + _copy._count);
             return *this;
         }
 
+        /// \brief Move arguments
+        /// The destination takes on the arena of the source along with its memory.
+        inline Arguments& operator=(Arguments&& _move) noexcept {
+            if(this == &_move)
+                return *this;
+            free();
+            _arena = _move._arena;
+            take(_move);
+            return *this;
+        }
+
         Arguments operator+(const Arguments& rhs) {
             Arguments a(_count + rhs._count);
             a.copy(args, args + _count);                         // left
-            a.copy(rhs.args, rhs.args + rhs._count, a._count);    // right
+            a.copy(rhs.args, rhs.args + rhs._count);             // right
             return a;
         }
 
@@ -250,10 +309,27 @@ namespace Rest {
             return Argument::null;
         }
 
+        /// \brief Find an argument by interned name, compares integers rather than strings
+        const Argument& operator[](const ArgumentName& _name) const {
+            int i = indexOf(_name);
+            return (i >= 0)
+                   ? args[i]
+                   : Argument::null;
+        }
+
+        /// \brief Position of the argument with the given name, or -1 if there is no such argument
+        int indexOf(const ArgumentName& _name) const {
+            for(decltype(_count) i=0; i<_count; i++) {
+                if (args[i].name_id == _name.id)
+                    return i;
+            }
+            return -1;
+        }
+
         Argument& add(Type& t) {
             // ensure we have room to add
             if(_count >= _capacity)
-                alloc(_capacity+1);
+                grow();
             assert(_count < _capacity);
 
             // add the argument
@@ -262,64 +338,195 @@ namespace Rest {
             return *arg;
         }
 
+        /// \brief Add a copy of an argument
+        /// String values are copied into the arena if there is one, otherwise onto the heap.
         Argument& add(const Argument& t) {
             // ensure we have room to add
             if(_count >= _capacity)
-                alloc(_capacity+1);
+                grow();
             assert(_count < _capacity);
 
             // add the argument
-            Argument* arg = new (&args[_count++]) Argument(t);    // placement copy constructor
-            assert(arg);
+            Argument* arg = &args[_count++];
+            *arg = t;
+            if(arg->type == ARG_MASK_STRING)
+                arg->s = dup(t.s, t.length());
             return *arg;
         }
 
-        inline void reserve(_size_t _count) { alloc(_count); }
+        /// \brief Add a string argument from a range of characters
+        /// The string is copied into the arena if there is one, otherwise onto the heap.
+        Argument& add(const Type& t, const char* _s, size_t n) {
+            // ensure we have room to add
+            if(_count >= _capacity)
+                grow();
+            assert(_count < _capacity);
+
+            Argument* arg = new (&args[_count++]) Argument(t);
+            arg->type = ARG_MASK_STRING;
+            arg->setLength(n);
+            arg->s = dup(_s, n);
+            return *arg;
+        }
+
+        /// \brief Ensure there is room for at least n arguments
+        /// Reserving never shrinks the capacity, and n at or below the inline capacity never allocates.
+        inline void reserve(_size_t n) {
+            if(n > _capacity)
+                alloc(n);
+        }
+
+        /// \brief Remove all arguments but keep the memory
+        inline void clear() { truncate(0); }
+
+        /// \brief Remove the arguments after the first n
+        void truncate(_size_t n) {
+            if(_arena == nullptr) {
+                // strings on the heap are owned by us
+                for(Argument *a = args + n, *_a = args + _count; a < _a; a++) {
+                    if(a->type == ARG_MASK_STRING)
+                        ::free(a->s);
+                }
+            }
+            if(n < _count)
+                _count = n;
+        }
 
         inline _size_t count() const { return _count; }
 
         inline _size_t capacity() const { return _capacity; }
 
+        /// \brief The arena the arguments are allocated from, or null if allocated on the heap
+        inline PagedPool* arena() const { return _arena; }
+
+        /// \brief True if the arguments are stored within the Arguments object
+        inline bool isInline() const { return args == inlined(); }
+
     protected:
         Argument* args;
         _size_t _capacity;
         _size_t _count;
+        PagedPool* _arena;
+
+        // inline storage for the first few arguments, args points here until we outgrow it
+        alignas(Argument) unsigned char _inline[inline_capacity * sizeof(Argument)];
+
+        inline Argument* inlined() { return (Argument*)_inline; }
+        inline const Argument* inlined() const { return (const Argument*)_inline; }
+
+        /// \brief grow geometrically so adding arguments one at a time is amortized O(1)
+        inline void grow() { alloc(_capacity * 2); }
+
+        /// \brief move the arguments into new memory with room for n arguments
+        /// Arena memory cannot be resized or freed, the old block is left to the arena.
+        void alloc(_size_t n) {
+            Argument* _args = (_arena != nullptr)
+                    ? (Argument*)_arena->allocate(n * sizeof(Argument), alignof(Argument))
+                    : (Argument*)malloc(n * sizeof(Argument));
+            memcpy((void*)_args, (void*)args, _count * sizeof(Argument));
+            release();
+            args = _args;
+            _capacity = n;
+        }
 
-        void alloc(_size_t _count) {
-            if(_count ==0) {
-                // just free
-                free();
-            } else if(_count != _capacity) {
-                _capacity = _count;
-                args = (args != nullptr)
-                    ? (Argument*)realloc(args, _capacity * sizeof(Argument))
-                    : (Argument*)calloc(_capacity, sizeof(Argument));
+        /// \brief take over the arguments of another Arguments object, leaving it empty
+        void take(Arguments& from) {
+            if(from.isInline()) {
+                memcpy((void*)args, (void*)from.args, from._count * sizeof(Argument));
+            } else {
+                args = from.args;
+                _capacity = from._capacity;
+                from.args = from.inlined();
+                from._capacity = inline_capacity;
             }
+            _count = from._count;
+            from._count = 0;
         }
 
-        void free() {
-            if(args) {
-                //for(Argument *a = args, *_a=args+nargs; a < _a; a++)
-                //    a->~Argument();
+        /// \brief allocate a null terminated copy of a string range from the arena or heap
+        char* dup(const char* _s, size_t n) {
+            char* out = (_arena != nullptr)
+                    ? (char*)_arena->allocate(n + 1, 1)
+                    : (char*)malloc(n + 1);
+            memcpy(out, _s, n);
+            out[n] = 0;
+            return out;
+        }
+
+        /// \brief release the argument memory if it came from the heap, arena memory is released by the arena
+        void release() {
+            if(!isInline() && _arena == nullptr)
                 ::free(args);
-                args = nullptr;
-                _capacity = 0;
-                _count = 0;
-            }
+            args = inlined();
+            _capacity = inline_capacity;
         }
 
-        void copy(Argument* begin, Argument* end, _size_t dest_index=0) {
-            _size_t n = end - begin;
-            if(_capacity < n)
-                alloc( n );
+        void free() {
+            clear();
+            release();
+        }
 
-            Argument* dest = args + dest_index;
-            while(begin < end) {
-                new(dest++) Argument(*begin++);    // placement copy constructor
-                _count++;
-            }
+        void copy(const Argument* begin, const Argument* end) {
+            reserve(_count + (end - begin));
+            while(begin < end)
+                add(*begin++);
         }
     };
 
+    /// \brief Decodes an Argument into a native handler parameter
+    /// A typed handler such as int(Request&, long id, const char* name) receives each Uri argument as a parameter of
+    /// one of these types. The mask is the set of ARG_MASK_xxxx types a parameter can hold, when the handler is
+    /// attached every argument declared by the endpoint must be one of them so get() never checks the type.
+    template<class T>
+    struct ArgumentValue {
+        static_assert(sizeof(T) == 0, "handler parameter is not a supported argument type");
+    };
+
+    // a real number also matches an argument declared as an integer, integer parameters receive it truncated
+    inline bool argument_is_real(const Argument& a) { return (a.type & ARG_MASK_REAL) == ARG_MASK_REAL; }
+
+    template<> struct ArgumentValue<long> {
+        static constexpr unsigned short mask = ARG_MASK_UINTEGER;
+        static inline long get(const Argument& a) { return argument_is_real(a) ? (long)a.d : a.l; }
+    };
+
+    template<> struct ArgumentValue<int> {
+        static constexpr unsigned short mask = ARG_MASK_UINTEGER;
+        static inline int get(const Argument& a) { return argument_is_real(a) ? (int)a.d : (int)a.l; }
+    };
+
+    template<> struct ArgumentValue<unsigned long> {
+        static constexpr unsigned short mask = ARG_MASK_UINTEGER;
+        static inline unsigned long get(const Argument& a) { return argument_is_real(a) ? (unsigned long)a.d : a.ul; }
+    };
+
+    template<> struct ArgumentValue<unsigned int> {
+        static constexpr unsigned short mask = ARG_MASK_UINTEGER;
+        static inline unsigned int get(const Argument& a) { return argument_is_real(a) ? (unsigned int)a.d : (unsigned int)a.ul; }
+    };
+
+    template<> struct ArgumentValue<double> {
+        static constexpr unsigned short mask = ARG_MASK_NUMBER;
+        static inline double get(const Argument& a) { return argument_is_real(a) ? a.d : (double)a.l; }
+    };
+
+    template<> struct ArgumentValue<bool> {
+        static constexpr unsigned short mask = ARG_MASK_BOOLEAN;
+        static inline bool get(const Argument& a) { return a.b; }
+    };
+
+    template<> struct ArgumentValue<const char*> {
+        static constexpr unsigned short mask = ARG_MASK_STRING;
+        static inline const char* get(const Argument& a) { return a.s; }
+    };
+
+    // receives the argument as is, for arguments declared with more than one type
+    template<> struct ArgumentValue<const Argument&> {
+        static constexpr unsigned short mask = ARG_MASK_ANY|ARG_MASK_UNSIGNED;
+        static inline const Argument& get(const Argument& a) { return a; }
+    };
+
+    template<> struct ArgumentValue<Argument> : ArgumentValue<const Argument&> {};
+
 
 }; // ns: Rest
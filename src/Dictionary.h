@@ -0,0 +1,122 @@
+//
+// Created by Colin MacKenzie on 2019-06-23.
+//
+
+#pragma once
+
+#include "Pool.h"
+#include "binbag.h"
+
+#include <atomic>
+#include <cstring>
+
+namespace Rest {
+
+    /// \brief A reference counted dictionary of the words used as literals by Endpoints
+    /// Every literal of an Endpoints collection refers to its word by id in a dictionary. By default each Endpoints has
+    /// a dictionary of its own so finding a word only involves the words of its own routes, and the memory is released
+    /// along with the Endpoints. Collections that should share words, such as the route sets of one tenant, can be given
+    /// the same dictionary. Copies of a Dictionary refer to the same words, which are freed when the last copy goes.
+    ///
+    /// Argument names are not kept here, they are interned process wide in literals_index so ArgumentName ids compare
+    /// equal across every collection and request.
+    class Dictionary {
+    public:
+        /// \brief Create a new empty dictionary
+        Dictionary() : shared(new Shared()) {
+            shared->words = createIndex();
+            shared->refs = 1;
+        }
+
+        /// \brief Refer to the same words as copy
+        Dictionary(const Dictionary& copy) : shared(copy.shared) {
+            if(shared != nullptr)
+                shared->refs++;
+        }
+
+        Dictionary(Dictionary&& move) noexcept : shared(move.shared) {
+            move.shared = nullptr;
+        }
+
+        ~Dictionary() {
+            release();
+        }
+
+        Dictionary& operator=(const Dictionary& copy) {
+            if(shared != copy.shared) {
+                if(copy.shared != nullptr)
+                    copy.shared->refs++;
+                release();
+                shared = copy.shared;
+            }
+            return *this;
+        }
+
+        Dictionary& operator=(Dictionary&& move) noexcept {
+            if(this != &move) {
+                release();
+                shared = move.shared;
+                move.shared = nullptr;
+            }
+            return *this;
+        }
+
+        /// \brief True if both refer to the same words
+        inline bool operator==(const Dictionary& rhs) const { return shared == rhs.shared; }
+        inline bool operator!=(const Dictionary& rhs) const { return shared != rhs.shared; }
+
+        /// \brief The string table holding the words, word ids are ordinals into it
+        inline binbag* words() const { return (shared != nullptr) ? shared->words : nullptr; }
+
+        /// \brief The number of Dictionary objects referring to these words
+        inline unsigned long refs() const { return (shared != nullptr) ? shared->refs.load() : 0; }
+
+        inline size_t size() const { return (shared != nullptr) ? binbag_count(shared->words) : 0; }
+
+        inline const char* get(long id) const { return binbag_get(shared->words, id); }
+
+        /// \brief Returns the id of a word ignoring case, or -1 if it is not in the dictionary
+        inline long find(const char* word) const { return binbag_find_nocase(shared->words, word); }
+        inline long find(const char* word, size_t length) const { return binbag_find_nocase_n(shared->words, word, length); }
+
+        /// \brief Returns the id of a word, adding it if it is not in the dictionary yet
+        inline long insert(const char* word) { return binbag_insert_distinct(shared->words, word, strcasecmp); }
+
+        /// \brief Allocate a string table set up the way dictionaries use it
+        /// Strings are stored in chunks so they never move, are case folded and kept in a case insensitive index.
+        static binbag* createIndex() {
+            binbag* bb = binbag_create_chunked(256);
+            if(bb != nullptr) {
+                binbag_mode(bb, BB_MODE_FOLDED);
+                binbag_index(bb, BB_INDEX_NOCASE);
+            }
+            return bb;
+        }
+
+    protected:
+        struct Shared {
+            binbag* words;
+            std::atomic<unsigned long> refs;
+        };
+
+        Shared* shared;
+
+        void release() {
+            if(shared != nullptr && --shared->refs == 0) {
+                if(shared->words != nullptr)
+                    binbag_free(shared->words);
+                delete shared;
+            }
+            shared = nullptr;
+        }
+    };
+
+    /// \brief Create the process wide index of argument names if it does not exist yet
+    /// Safe to call from more than one thread, the index is only created once.
+    inline binbag* initLiteralsIndex() {
+        static bool created = (literals_index == nullptr) && (literals_index = Dictionary::createIndex()) != nullptr;
+        (void)created;
+        return literals_index;
+    }
+
+}
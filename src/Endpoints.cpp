@@ -38,6 +38,7 @@ namespace Rest {
     binbag* literals_index = nullptr;
 
     const Argument Argument::null;
+    constexpr Arguments::_size_t Arguments::inline_capacity;
 
 const char* uri_method_to_string(HttpMethod method) {
     switch(method) {
@@ -47,6 +48,7 @@ const char* uri_method_to_string(HttpMethod method) {
         case HttpPatch: return "PATCH";
         case HttpDelete: return "DELETE";
         case HttpOptions: return "OPTIONS";
+        case HttpHead: return "HEAD";
         case HttpMethodAny: return "ANY";
         default: return "GET";
     }
@@ -6,6 +6,7 @@
 #include <sys/types.h>
 #include <cassert>
 #include <functional>
+#include <atomic>
 
 
 #include "Token.h"
@@ -14,7 +15,11 @@
 #include "Literal.h"
 #include "Mixins.h"
 #include "Pool.h"
+#include "Dictionary.h"
 #include "Parser.h"
+#include "FrozenTable.h"
+#include "StaticRoutes.h"
+#include "LiteralProfile.h"
 #include "handler.h"
 
 // format:    /api/test/:param_name(integer|real|number|string|boolean)/method
@@ -42,6 +47,10 @@ public:
 
     using HandlerTraits = Rest::function_traits<THandler>;
 
+    using FrozenTable = Rest::FrozenTable<TNodeData>;
+    using StaticRoutes = Rest::StaticRoutes<TNodeData>;
+    using LiteralProfile = Rest::LiteralProfile<TNodeData>;
+
     template<class Klass>
     using ClassEndpoints = Endpoints< typename HandlerTraits::template CVFunctionType<Klass> >;
 
@@ -54,29 +63,53 @@ public:
 
 public:
     /// \brief Initialize an empty UriExpression with a maximum number of code size.
+    /// The words of the endpoints are kept in a dictionary of their own.
     Endpoints()
         : pool( (sizeof(NodeData)+sizeof(Literal))*8 ),
-          ep_head(nullptr), maxUriArgs(0)
+          ep_head(nullptr), frozen(nullptr), maxUriArgs(0),
+          countHits(false), adaptInterval(0), adaptResolves(0)
     {
-        if(literals_index == nullptr) {
-            literals_index = binbag_create(128, 1.5);
-        }
+        initLiteralsIndex();
+    }
+
+    /// \brief Initialize an empty UriExpression that keeps its words in a shared dictionary
+    explicit Endpoints(const Dictionary& _dictionary)
+        : pool( (sizeof(NodeData)+sizeof(Literal))*8 ), dictionary(_dictionary),
+          ep_head(nullptr), frozen(nullptr), maxUriArgs(0),
+          countHits(false), adaptInterval(0), adaptResolves(0)
+    {
+        initLiteralsIndex();
     }
 
     /// \brief Move constructor
-    /// moves endpoints and resources from one Endpoints instance to another.
-    Endpoints(Endpoints&& other) noexcept
-        : pool(other.pool), ep_head(other.ep_head), maxUriArgs(other.maxUriArgs) {
-          other.free(false);
+    /// moves endpoints and resources from one Endpoints instance to another. The moved from instance is left empty
+    /// with a new dictionary of its own, so endpoints can still be declared and resolved on it.
+    Endpoints(Endpoints&& other)
+        : pool(std::move(other.pool)), dictionary(std::move(other.dictionary)), ep_head(other.ep_head),
+          frozen(other.frozen), routes(std::move(other.routes)),
+          maxUriArgs(other.maxUriArgs),
+          countHits(other.countHits), adaptInterval(other.adaptInterval), adaptResolves(other.adaptResolves.load()) {
+        other.reset();
     }
 
     /// \brief Move assignment operator
-    /// moves endpoints and resources from one Endpoints instance to another.
-    Endpoints& operator=(Endpoints&& other) noexcept {
-        pool = other.pool;
-        ep_head = other.ep_head;
-        maxUriArgs = other.maxUriArgs;
-        other.free(false);
+    /// moves endpoints and resources from one Endpoints instance to another. The moved from instance is left empty
+    /// with a new dictionary of its own.
+    Endpoints& operator=(Endpoints&& other) {
+        if(this != &other) {
+            thaw();
+            pool = std::move(other.pool);
+            dictionary = std::move(other.dictionary);
+            ep_head = other.ep_head;
+            frozen = other.frozen;
+            routes = std::move(other.routes);
+            maxUriArgs = other.maxUriArgs;
+            countHits = other.countHits;
+            adaptInterval = other.adaptInterval;
+            adaptResolves = other.adaptResolves.load();
+            other.reset();
+        }
+        return *this;
     }
 
     /// \brief Copy constructor (not allowed)
@@ -91,6 +124,7 @@ public:
 
     /// \brief Destroys the RestUriExpression and releases memory
     virtual ~Endpoints() {
+        thaw();
     }
 
     Node on(const char* expression) {
@@ -103,6 +137,139 @@ public:
             : getRoot().resolve(method, expression);
     }
 
+    /// \brief Resolve a Uri allocating the arguments from a request arena
+    /// Saves allocating on the heap for every resolve. The arena should be reset when the request has been handled,
+    /// which releases the arguments of the returned request.
+    Request resolve(HttpMethod method, const char* uri, PagedPool& arena) {
+        Request request(method, uri, arena);
+        resolve(request);
+        return request;
+    }
+
+    /// \brief Resolve the Uri of a request
+    /// The request Uri must be null terminated unless uri_end is given.
+    bool resolve(Request& request, const char* uri_end = nullptr) {
+        if(ep_head == nullptr) {
+            request.status = URL_FAIL_NULL_ROOT;
+            return false;
+        }
+        return getRoot().resolve(request, uri_end);
+    }
+
+    /// \brief Resolve a Uri given as a buffer and length
+    /// The buffer does not need to be null terminated, and anything from a '?' on is ignored so a raw request line
+    /// with a query string can be resolved without copying.
+    Request resolve(HttpMethod method, const char* uri, size_t length) {
+        return (ep_head == nullptr)
+            ? Request(method, uri, URL_FAIL_NULL_ROOT)
+            : getRoot().resolve(method, uri, length);
+    }
+
+    /// \brief Compile the endpoints into a flat, read-only routing table
+    /// Once all endpoints are added, freezing lays the node graph out in contiguous arrays so resolves from the root
+    /// stop chasing pointers through the pool. Identical subtrees of the graph share one copy in the table. Adding
+    /// endpoints using on() thaws the table again, call freeze() once more when you are done.
+    bool freeze(typename FrozenTable::MatchStrategy strategy = FrozenTable::HashMatch) {
+        thaw();
+        if(ep_head == nullptr)
+            return false;
+        updateMethods();
+        frozen = new FrozenTable(ep_head, dictionary.words(), strategy, countHits);
+        return frozen != nullptr;
+    }
+
+    /// \brief Release the frozen routing table and go back to resolving against the node graph
+    void thaw() {
+        if(frozen != nullptr) {
+            delete frozen;
+            frozen = nullptr;
+        }
+    }
+
+    inline bool isFrozen() const { return frozen != nullptr; }
+
+    /// \brief Compile the frozen table again, if there is one, keeping its options
+    void refreeze() {
+        if(frozen != nullptr) {
+            auto strategy = frozen->matchStrategy();
+            delete frozen;
+            frozen = new FrozenTable(ep_head, dictionary.words(), strategy, countHits);
+        }
+    }
+
+    /// \brief Note that the handlers or externals of node changed
+    /// Everything resolving reads is brought up to date right away, so resolving never modifies the endpoints. The
+    /// static route of the node is added to the table rather than building the whole table again.
+    void handlersChanged(NodeData* node) {
+        if(frozen != nullptr) {
+            updateMethods();
+            return;
+        }
+        if(ep_head != nullptr)
+            ep_head->updateReachable();
+        routes.insert(ep_head, dictionary.words(), node);
+    }
+
+    /// \brief Recompute the methods reachable below each node, the table of static routes and the frozen table
+    void updateMethods() {
+        if(ep_head != nullptr)
+            ep_head->updateReachable();
+        routes.build(ep_head, dictionary.words());
+        if(frozen != nullptr) {
+            if(frozen->shared() > 0)
+                refreeze();     // a handler may have been attached to a node that shares the table entry of another
+            else
+                frozen->updateMethods();
+        }
+    }
+
+    /// \brief Count how often each literal matches and keep the busiest literals first
+    /// While counting, every literal records its hits. Call reorder() to sort the literals by their hits, it changes
+    /// the node graph so it must not run while other threads resolve. Given an interval, reorderDue() tells when that
+    /// many resolves have passed since the last reorder(). adapt(false) stops counting but keeps the current order.
+    void adapt(bool count, unsigned long interval = 0) {
+        countHits = count;
+        adaptInterval = count ? interval : 0;
+        adaptResolves = 0;
+        if(frozen != nullptr && frozen->countsHits() != count)
+            refreeze();
+    }
+
+    /// \brief True once the interval given to adapt() has passed since the literals were last reordered
+    inline bool reorderDue() const {
+        return adaptInterval != 0 && adaptResolves.load(std::memory_order_relaxed) >= adaptInterval;
+    }
+
+    /// \brief Sort the literals of every node by their hits, busiest first
+    /// The literal lists and the frozen table are rebuilt, no other thread may resolve meanwhile.
+    void reorder() {
+        adaptResolves = 0;
+        if(ep_head == nullptr)
+            return;
+        LiteralProfile::reorder(ep_head);
+        refreeze();
+    }
+
+    /// \brief Returns the hit counts of the literals as text that can be saved and given to loadProfile() later
+    std::string saveProfile() const {
+        return (ep_head != nullptr) ? LiteralProfile::save(ep_head, dictionary.words()) : std::string();
+    }
+
+    /// \brief Set the hit counts of the literals from a saved profile and reorder the literals to match
+    /// Declare all endpoints first, lines for endpoints that no longer exist are skipped. Returns the number of
+    /// literals that were set.
+    size_t loadProfile(const char* profile) {
+        if(ep_head == nullptr)
+            return 0;
+        size_t loaded = LiteralProfile::load(ep_head, dictionary.words(), profile);
+        reorder();
+        return loaded;
+    }
+
+    /// \brief The dictionary holding the words of the endpoints
+    /// Give it to the constructor of other Endpoints to have them share the same words.
+    inline const Dictionary& getDictionary() const { return dictionary; }
+
     inline Node getRoot() {
         return Node(this,
             (ep_head == nullptr)
@@ -123,8 +290,24 @@ public:
         return pool.make<ArgumentType>(literal_id, typemask);
     }
 
+    ArgumentType* newArgumentType(const char* name, unsigned short typemask) {
+        return pool.make<ArgumentType>(name, typemask);
+    }
+
+    uint32_t* newArgumentNames(size_t n) {
+        return (uint32_t*)pool.allocate(n * sizeof(uint32_t), alignof(uint32_t));
+    }
+
+    uint16_t* newArgumentTypes(size_t n) {
+        return (uint16_t*)pool.allocate(n * sizeof(uint16_t), alignof(uint16_t));
+    }
+
     long findLiteral(const char* word) {
-        return binbag_find_nocase(literals_index, word);
+        return dictionary.find(word);
+    }
+
+    long findLiteral(const char* word, size_t length) {
+        return dictionary.find(word, length);
     }
 
     Literal* newLiteral(TNodeData* ep, Literal* literal)
@@ -146,8 +329,12 @@ public:
     {
         Literal lit;
         lit.isNumeric = false;
-        if((lit.id = binbag_find_nocase(literals_index, literal_value)) <0)
-            lit.id = binbag_insert(literals_index, literal_value);  // insert value into the binbag, and record the index into the id field
+        lit.id = dictionary.insert(literal_value);     // record the index of the word in the dictionary into the id field
+        size_t length = strlen(literal_value);
+        if(length <= WORD_INLINE_SIZE) {
+            lit.word = fold_word(literal_value, length);
+            lit.length = (uint8_t)length;
+        }
         lit.nextNode = nullptr;
         return newLiteral(ep, &lit);
     }
@@ -161,14 +348,50 @@ public:
         return newLiteral(ep, &lit);
     }
 
+protected:
+    /// \brief Forget the endpoints after they were moved to another instance
+    /// The pool and frozen table now belong to the other instance. Dictionary lookups do not check for a missing
+    /// dictionary so a new one is created.
+    void reset() {
+        frozen = nullptr;
+        ep_head = nullptr;
+        dictionary = Dictionary();
+        routes.clear();
+        maxUriArgs = 0;
+        countHits = false;
+        adaptInterval = 0;
+        adaptResolves = 0;
+    }
+
 public:
     // stores the expression as a chain of endpoint nodes
     PagedPool pool;
+
+    // the words of the literals, literal ids are indexes into it
+    Dictionary dictionary;
+
     TNodeData *ep_head;
 
+    // flat copy of the expression tree, only exists after freeze()
+    FrozenTable *frozen;
+
+    // endpoints that have no arguments or wildcards, by path
+    StaticRoutes routes;
+
     // some statistics on the endpoints
     size_t maxUriArgs;       // maximum number of embedded arguments on any one endpoint expression
+
+    // adaptive literal ordering, see adapt()
+    bool countHits;
+    unsigned long adaptInterval;    // reorder is due after this many resolves, or 0 to only count
+    std::atomic<unsigned long> adaptResolves;   // resolves since literals were last reordered
 };
 
+/// \brief Endpoints whose handlers are plain function pointers
+/// The smallest handler type, each handler slot in a node is a single pointer. Handlers cannot capture state, use
+/// InlineHandler for small lambdas.
+template<class... TArgs>
+using FunctionEndpoints = Endpoints< int(*)(TArgs...) >;
+
 
 } // ns:Rest
@@ -0,0 +1,653 @@
+//
+// Created by Colin MacKenzie on 2019-06-02.
+//
+
+#pragma once
+
+#include "Parser.h"
+
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace Rest {
+
+    /// \brief A flat, read-only copy of an Endpoints node graph
+    /// Endpoints::freeze() walks the node graph built by on() and lays the nodes, literals and argument types out
+    /// breadth-first in contiguous arrays that refer to each other by index instead of by pointer. Resolving against the
+    /// table walks a few small arrays rather than chasing NodeData, Literal and ArgumentType pointers across PagedPool
+    /// pages. Handlers and externals stay in the original NodeData, the table keeps a parallel array of NodeData
+    /// pointers to reach them once a node has been matched.
+    ///
+    /// Literals are matched on the segment hash computed by Token::scan() and a copy of the literal text kept in the
+    /// table, so resolving never searches the shared literals index. Nodes with many literals get their own open
+    /// addressing hash table so matching a segment is a single probe rather than a walk of every literal. Nodes with a
+    /// mid-size number of literals can instead keep the first 16 bytes of each literal, lower cased, in a contiguous
+    /// block that is compared to the segment 16 bytes at a time (see PrefixMatch).
+    ///
+    /// A literal that leads into a chain of nodes each with nothing but a single literal, such as /api/v1/system/network,
+    /// also keeps the text of the rest of the chain. Resolving compares the chain in one go and jumps to the node at the
+    /// end of it. The nodes of the chain stay in the table and are walked one segment at a time when the Uri leaves
+    /// the chain part way, so the result is always the same as resolving against the node graph.
+    ///
+    /// Identical subtrees, such as the same sub-api mounted under many device prefixes, are laid out only once. Before
+    /// compiling, nodes are compared bottom up and a node shares the table entry of an earlier node when both have the
+    /// same literals, argument types, argument names and handlers and their edges lead to shared nodes. Nodes with
+    /// externals, and handlers that cannot be compared (see same_handler()), are never shared.
+    template<class TNodeData>
+    class FrozenTable {
+    public:
+        using NodeData = TNodeData;
+        using index_type = uint32_t;
+        using count_type = uint16_t;
+
+        static constexpr index_type npos = (index_type)-1;
+
+        /// nodes with at least this many literals get a hash table
+        static constexpr count_type hash_threshold = 8;
+
+        /// nodes with up to this many literals can use prefix matching instead of a hash table
+        static constexpr count_type prefix_limit = 64;
+
+        /// bytes of each literal kept in the prefix block
+        static constexpr size_t prefix_size = 16;
+
+        /// \brief How literals are matched at nodes with between hash_threshold and prefix_limit literals
+        /// HashMatch probes the node's hash table with the hash of the segment computed while scanning. PrefixMatch
+        /// compares the lower cased segment to the prefix of every literal with SSE2 byte compares where available.
+        /// Nodes with more literals are always hashed, nodes with fewer are searched one literal at a time.
+        typedef enum {
+            HashMatch,
+            PrefixMatch
+        } MatchStrategy;
+
+        /// \brief A node of the routing table
+        /// Literal edges of a node are stored consecutively, so a node only records its first literal and a count.
+        struct Node {
+            index_type literals;                // first literal edge
+            index_type string, numeric, boolean;// argument edges (may refer to the same edge)
+            index_type wild;                    // node to jump to when nothing else matches
+            index_type buckets;                 // first hash bucket, or offset in the prefix block, of this node's literals
+            count_type nliterals;               // number of literal edges
+            uint16_t reachable;                 // methods handled at or below this node
+            uint8_t bucket_bits;                // hash table has 2^bucket_bits buckets, or zero if not hashed
+            bool prefixed;                      // literals are matched using the prefix block
+        };
+
+        /// \brief A literal edge, matched by the hash and text of the word
+        /// Words of up to WORD_INLINE_SIZE characters are matched on their packed form instead of the text.
+        struct Literal {
+            uint64_t word;                      // literal packed by fold_word() if it is short
+            uint32_t hash;                      // case insensitive hash of the literal text
+            index_type text;                    // offset of the literal text in the text block
+            index_type next;                    // node to jump to if this literal matches
+            index_type chain;                   // offset of the text of the chain of literals that follows, or npos
+            index_type skip;                    // node at the end of the chain
+            uint8_t length;                     // length of a short literal, or zero if matched on the text
+        };
+
+        /// \brief An argument edge, matched by the type of the token
+        struct Argument {
+            uint32_t name;                      // index of argument name in the literal index
+            uint16_t typemask;
+            index_type next;                    // node to jump to if this argument matches
+
+            inline Type type() const { return Type((long)name, typemask); }
+        };
+
+    public:
+        /// \brief Compile the graph starting at root
+        /// If count_hits is true, resolving counts the hits of each literal matched in the literal of the node graph
+        /// it came from, see LiteralProfile. The ids of the literals are words in dictionary.
+        FrozenTable(NodeData* root, binbag* dictionary, MatchStrategy _strategy = HashMatch, bool count_hits = false)
+            : words(dictionary), strategy(_strategy), counting(count_hits)
+        {
+            compile(root);
+        }
+
+        FrozenTable(const FrozenTable& copy) = delete;
+        FrozenTable& operator=(const FrozenTable& copy) = delete;
+
+        inline size_t size() const { return nodes.size(); }
+
+        /// \brief Returns the number of nodes of the graph that share the table entry of an identical node.
+        inline size_t shared() const { return nshared; }
+
+        /// \brief Returns a node of the table, the root node is 0.
+        inline const Node& node(index_type n) const { return nodes[n]; }
+
+        /// \brief Returns the node data that was the source for the given table node.
+        inline NodeData* data(index_type n) const { return sources[n]; }
+
+        /// \brief Returns the number of bytes used by the table.
+        size_t bytes() const {
+            return sizeof(FrozenTable)
+                + nodes.capacity() * sizeof(Node)
+                + literals.capacity() * sizeof(Literal)
+                + arguments.capacity() * sizeof(Argument)
+                + buckets.capacity() * sizeof(index_type)
+                + text.capacity()
+                + prefixes.capacity()
+                + sources.capacity() * sizeof(NodeData*)
+                + origins.capacity() * sizeof(typename NodeData::LiteralType*);
+        }
+
+        /// \brief Resolves a Uri against the table
+        /// This is the table equivalent of Parser::parse() in resolve mode. Parsing starts at node 'n' and on return
+        /// 'n' is updated to the last node that was matched, even if the Uri did not match fully, so the caller can
+        /// continue into any externals attached to that node.
+        ParseResult resolve(ParserState* ev, index_type& n) const
+        {
+            uint16_t method = NodeData::requestBit(ev->request.method);
+            while(ev->t.id!=TID_EOF) {
+                rescan:
+                const Node& epc = nodes[n];
+                if((epc.reachable & method) == 0)
+                    return NoHandler;       // nothing below here handles the method
+
+                switch(ev->state) {
+                    case expectPathPartOrSep:
+                        GOTO_STATE( (ev->t.id=='/')
+                                    ? expectPathSep
+                                    : expectPathPart
+                        );
+                    case expectPathSep:
+                        if(ev->t.id=='/')
+                            NEXT_STATE(expectPathPart);
+                        break;
+                    case expectPathPart: {
+                        if(ev->t.is(TID_STRING, TID_IDENTIFIER)) {
+                            const Literal *lit = findLiteral(epc, ev->t);
+                            if(lit != nullptr) {
+                                if(counting)
+                                    origins[lit - literals.data()]->hits.fetch_add(1, std::memory_order_relaxed);
+                                n = (lit->chain != npos && skipChain(ev, *lit))
+                                    ? lit->skip
+                                    : lit->next;
+                                NEXT_STATE( expectPathSep );
+                            } else if(epc.string != npos) {
+                                GOTO_STATE(expectParameterValue);
+                            } else
+                                return wildcard(ev, n);
+                        } else
+                            GOTO_STATE(expectParameterValue);
+                    } break;
+                    case expectParameterValue: {
+                        // try to match a parameter by type
+                        if(ev->t.is(TID_STRING, TID_IDENTIFIER) && epc.string!=npos) {
+                            const Argument& arg = arguments[epc.string];
+                            ev->request.args.add( arg.type(), ev->t.s, ev->t.len );
+                            n = arg.next;
+                        } else if(ev->t.id==TID_INTEGER && epc.numeric!=npos) {
+                            const Argument& arg = arguments[epc.numeric];
+                            ev->request.args.add( Rest::Argument(arg.type(), (long)ev->t.i) );
+                            n = arg.next;
+                        } else if(ev->t.id==TID_FLOAT && epc.numeric!=npos) {
+                            const Argument& arg = arguments[epc.numeric];
+                            ev->request.args.add( Rest::Argument(arg.type(), ev->t.d) );
+                            n = arg.next;
+                        } else if(ev->t.id==TID_BOOL && epc.boolean!=npos) {
+                            const Argument& arg = arguments[epc.boolean];
+                            ev->request.args.add( Rest::Argument(arg.type(), ev->t.i>0) );
+                            n = arg.next;
+                        } else
+                            return wildcard(ev, n);  // no match by type
+
+                        NEXT_STATE( expectPathSep );
+                    } break;
+                    default:
+                        return URL_FAIL_INTERNAL;   // not a resolve state
+                }
+
+                // next token
+                SCAN;
+            }
+
+            return UriMatched;
+        }
+
+        /// \brief Match the chain of literals following a literal that just matched
+        /// The chain text is compared to the input following the current token up to a segment boundary. On a match
+        /// the input continues after the chain, so the peek token is scanned again from there.
+        bool skipChain(ParserState* ev, const Literal& lit) const {
+            const char* chain = &text[lit.chain];
+            const char* p = ev->t.original + ev->t.len;
+            auto at = [ev,p](size_t k) -> char {
+                return (ev->end == nullptr || p + k < ev->end) ? p[k] : 0;
+            };
+
+            size_t k = 0;
+            for(; chain[k] != 0; k++)
+                if(tolower((unsigned char)at(k)) != tolower((unsigned char)chain[k]))
+                    return false;
+            char c = at(k);
+            if(c != 0 && c != '/' && c != '?')
+                return false;
+
+            ev->request.uri = p + k;
+            ev->peek.scan(&ev->request.uri, false, ev->end);
+            return true;
+        }
+
+        /// \brief Copy the reachable methods of every node again after handlers were attached to the node graph
+        void updateMethods() {
+            for(size_t i=0; i < nodes.size(); i++)
+                nodes[i].reachable = sources[i]->reachable;
+        }
+
+        /// \brief Find the literal edge of a node that matches the token
+        const Literal* findLiteral(const Node& node, const Token& t) const {
+            if(node.prefixed) {
+                return findPrefix(node, t);
+            } else if(node.bucket_bits > 0) {
+                // probe the node's hash table
+                index_type mask = ((index_type)1 << node.bucket_bits) - 1;
+                const index_type* table = buckets.data() + node.buckets;
+                for(index_type b = t.hash & mask; table[b] != npos; b = (b+1) & mask) {
+                    const Literal& l = literals[table[b]];
+                    if(matches(l, t))
+                        return &l;
+                }
+            } else {
+                for(const Literal *l = literals.data() + node.literals, *_l = l + node.nliterals; l < _l; l++) {
+                    if(matches(*l, t))
+                        return l;
+                }
+            }
+            return nullptr;
+        }
+
+        /// \brief True if the literal edge matches the token
+        inline bool matches(const Literal& l, const Token& t) const {
+            return l.hash == t.hash && ((l.length != 0)
+                                        ? l.length == t.len && l.word == t.word
+                                        : t.equals(&text[l.text]));
+        }
+
+        /// \brief Find the literal edge of a prefixed node that matches the token
+        /// A segment shorter than prefix_size matches when its prefix does, since the literal's prefix is padded with
+        /// nulls. Longer segments are confirmed against the full literal text.
+        const Literal* findPrefix(const Node& node, const Token& t) const {
+            alignas(16) uint8_t key[prefix_size] = { 0 };
+            memcpy(key, t.s, std::min(t.len, prefix_size));
+
+            const uint8_t* block = prefixes.data() + node.buckets;
+            for(count_type i = nextPrefix(key, block, 0, node.nliterals); i < node.nliterals;
+                    i = nextPrefix(key, block, i + 1, node.nliterals)) {
+                const Literal& l = literals[node.literals + i];
+                if(t.len < prefix_size || t.equals(&text[l.text]))
+                    return &l;
+            }
+            return nullptr;
+        }
+
+        /// \brief Index of the first prefix from i on that equals the lower cased key, or n if none do
+        static count_type nextPrefix(const uint8_t* key, const uint8_t* block, count_type i, count_type n) {
+#if defined(__SSE2__)
+            // lower case A-Z, bytes above 127 compare as negative and are left alone
+            __m128i k = _mm_load_si128((const __m128i*)key);
+            __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(k, _mm_set1_epi8('A' - 1)),
+                                          _mm_cmplt_epi8(k, _mm_set1_epi8('Z' + 1)));
+            k = _mm_add_epi8(k, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+
+            const __m128i* p = (const __m128i*)block;
+            for(; i + 4 <= n; i += 4) {
+                // test four prefixes before branching, most segments match none of them
+                int m0 = _mm_movemask_epi8(_mm_cmpeq_epi8(k, _mm_loadu_si128(p + i)));
+                int m1 = _mm_movemask_epi8(_mm_cmpeq_epi8(k, _mm_loadu_si128(p + i + 1)));
+                int m2 = _mm_movemask_epi8(_mm_cmpeq_epi8(k, _mm_loadu_si128(p + i + 2)));
+                int m3 = _mm_movemask_epi8(_mm_cmpeq_epi8(k, _mm_loadu_si128(p + i + 3)));
+                int hit = (m0 == 0xffff) | (m1 == 0xffff) << 1 | (m2 == 0xffff) << 2 | (m3 == 0xffff) << 3;
+                if(hit != 0)
+                    return (count_type)(i + __builtin_ctz(hit));
+            }
+            for(; i < n; i++)
+                if(_mm_movemask_epi8(_mm_cmpeq_epi8(k, _mm_loadu_si128(p + i))) == 0xffff)
+                    return i;
+#else
+            uint8_t folded[prefix_size];
+            for(size_t k=0; k < prefix_size; k++)
+                folded[k] = (uint8_t)tolower(key[k]);
+            for(; i < n; i++)
+                if(memcmp(folded, block + i*prefix_size, prefix_size) == 0)
+                    return i;
+#endif
+            return n;
+        }
+
+        /// \brief Returns the strategy used to match literals at mid-size nodes
+        inline MatchStrategy matchStrategy() const { return strategy; }
+
+        /// \brief True if resolving counts the hits of each literal
+        inline bool countsHits() const { return counting; }
+
+    protected:
+        binbag* words;
+        MatchStrategy strategy;
+        bool counting;
+
+        std::vector<Node> nodes;
+        std::vector<Literal> literals;
+        std::vector<Argument> arguments;
+        std::vector<NodeData*> sources;
+
+        // the literal of the node graph each literal edge was compiled from, only kept when counting hits
+        std::vector<typename NodeData::LiteralType*> origins;
+
+        // open addressing hash tables of the nodes with many literals, each bucket is a literal index or npos
+        std::vector<index_type> buckets;
+
+        // copy of the text of every literal word in the table
+        std::vector<char> text;
+
+        // lower cased first prefix_size bytes of the literals of prefixed nodes, padded with nulls
+        std::vector<uint8_t> prefixes;
+
+        // index of each node of the graph already queued while compiling
+        std::unordered_map<NodeData*, index_type> queued;
+
+        // the node that stands in for each node of the graph, the first of a set of identical subtrees
+        std::unordered_map<NodeData*, NodeData*> standins;
+
+        size_t nshared;
+
+        /// \brief Match the remainder of the Uri to the wildcard of node 'n' if it has one.
+        ParseResult wildcard(ParserState* ev, index_type& n) const {
+            const Node& epc = nodes[n];
+            if(epc.wild == npos)
+                return NoEndpoint;
+            n = epc.wild;
+            ev->request.args.add( Type("_url", ARG_MASK_STRING), ev->t.original, ev->remaining(ev->t.original) );
+            return UriMatchedWildcard;
+        }
+
+        index_type addArgument(typename NodeData::ArgumentType* arg) {
+            Argument a;
+            a.name = (uint32_t)arg->nameIndex();
+            a.typemask = arg->typemask();
+            a.next = enqueue(arg->nextNode);
+            arguments.push_back(a);
+            return (index_type)(arguments.size()-1);
+        }
+
+        index_type enqueue(NodeData* node) {
+            if(node == nullptr)
+                return npos;
+            node = standin(node);
+            auto existing = queued.find(node);
+            if(existing != queued.end())
+                return existing->second;
+            sources.push_back(node);
+            return queued[node] = (index_type)(sources.size()-1);
+        }
+
+        /// \brief The node that stands in for node in the table, or node itself if it is not shared
+        NodeData* standin(NodeData* node) const {
+            auto s = standins.find(node);
+            return (s != standins.end()) ? s->second : node;
+        }
+
+        /// \brief Hash of the parts of a node that must be the same for it to be shared
+        uint32_t signature(NodeData* node) const {
+            uint32_t h = FNV32_OFFSET_BASIS;
+            auto mix = [&h](uintptr_t v) { h = (h ^ (uint32_t)(v ^ (v >> 16))) * FNV32_PRIME; };
+            for(auto lit = node->literals; lit != nullptr && lit->isValid(); lit = lit->next) {
+                mix((uintptr_t)lit->id);
+                mix((uintptr_t)standin(lit->nextNode));
+            }
+            for(auto arg: { node->numeric, node->string, node->boolean }) {
+                if(arg != nullptr) {
+                    mix((uintptr_t)arg->nameIndex());
+                    mix(arg->typemask());
+                    mix((uintptr_t)standin(arg->nextNode));
+                }
+            }
+            mix((uintptr_t)standin(node->wild));
+            mix(node->methods);
+            mix(node->nargnames);
+            return h;
+        }
+
+        /// \brief True if node a can stand in for node b
+        /// The children of both nodes must already be shared, so edges are the same if they lead to the same stand in.
+        bool identical(NodeData* a, NodeData* b) const {
+            if(a->methods != b->methods || a->nargnames != b->nargnames
+               || a->externals != nullptr || b->externals != nullptr
+               || standin(a->wild) != standin(b->wild))
+                return false;
+
+            auto la = a->literals, lb = b->literals;
+            for(; la != nullptr && la->isValid(); la = la->next, lb = lb->next) {
+                if(lb == nullptr || !lb->isValid() || la->id != lb->id || la->isNumeric != lb->isNumeric
+                   || standin(la->nextNode) != standin(lb->nextNode))
+                    return false;
+            }
+            if(lb != nullptr && lb->isValid())
+                return false;
+
+            // arguments must match, including which token types share an argument
+            typename NodeData::ArgumentType* aa[] = { a->numeric, a->string, a->boolean };
+            typename NodeData::ArgumentType* ab[] = { b->numeric, b->string, b->boolean };
+            for(int i=0; i < 3; i++) {
+                if((aa[i] == nullptr) != (ab[i] == nullptr))
+                    return false;
+                if(aa[i] != nullptr && (aa[i]->nameIndex() != ab[i]->nameIndex() || aa[i]->typemask() != ab[i]->typemask()
+                                        || standin(aa[i]->nextNode) != standin(ab[i]->nextNode)))
+                    return false;
+                for(int j=0; j < i; j++)
+                    if((aa[i] != nullptr && aa[i] == aa[j]) != (ab[i] != nullptr && ab[i] == ab[j]))
+                        return false;
+            }
+
+            for(unsigned short i=0; i < a->nargnames; i++)
+                if(a->argnames[i] != b->argnames[i] || a->argtypes[i] != b->argtypes[i])
+                    return false;
+
+            for(int i=0, n=__builtin_popcount(a->methods); i < n; i++)
+                if(!same_handler(a->handlers[i], b->handlers[i]))
+                    return false;
+            return true;
+        }
+
+        /// \brief Find the stand in of every node below root, sharing identical subtrees
+        /// Nodes are visited children first without recursing, the children of a node are pushed back on the stack
+        /// behind it and the node is only compared once they are all done.
+        void share(NodeData* root) {
+            std::unordered_multimap<uint32_t, NodeData*> distinct;
+            std::unordered_set<NodeData*> visited;
+            std::vector< std::pair<NodeData*, bool> > stack;
+            stack.push_back(std::make_pair(root, false));
+            while(!stack.empty()) {
+                NodeData* node = stack.back().first;
+                bool expanded = stack.back().second;
+                if(!expanded) {
+                    if(!visited.insert(node).second) {
+                        stack.pop_back();
+                        continue;
+                    }
+                    stack.back().second = true;
+                    for(auto lit = node->literals; lit != nullptr && lit->isValid(); lit = lit->next)
+                        if(lit->nextNode != nullptr)
+                            stack.push_back(std::make_pair(lit->nextNode, false));
+                    for(auto arg: { node->numeric, node->string, node->boolean })
+                        if(arg != nullptr && arg->nextNode != nullptr)
+                            stack.push_back(std::make_pair(arg->nextNode, false));
+                    if(node->wild != nullptr)
+                        stack.push_back(std::make_pair(node->wild, false));
+                    continue;
+                }
+                stack.pop_back();
+
+                if(node->externals != nullptr)
+                    continue;
+                uint32_t h = signature(node);
+                auto range = distinct.equal_range(h);
+                auto match = range.first;
+                while(match != range.second && !identical(match->second, node))
+                    match++;
+                if(match != range.second) {
+                    standins[node] = match->second;
+                    nshared++;
+                } else
+                    distinct.insert(std::make_pair(h, node));
+            }
+        }
+
+        /// \brief The only literal of a node that has nothing else but that literal, or nullptr
+        static typename NodeData::LiteralType* chained(NodeData* node) {
+            auto lit = node->literals;
+            if(lit == nullptr || !lit->isValid() || lit->isNumeric || lit->nextNode == nullptr
+               || (lit->next != nullptr && lit->next->isValid())
+               || node->string != nullptr || node->numeric != nullptr || node->boolean != nullptr
+               || node->wild != nullptr || node->externals != nullptr || node->methods != 0)
+                return nullptr;
+            return lit;
+        }
+
+        /// \brief Add the text of the chain of single literal nodes starting at node, returns the node after the chain
+        NodeData* addChain(NodeData* node, Literal& l) {
+            l.chain = npos;
+            l.skip = npos;
+            typename NodeData::LiteralType* lit;
+            while(node != nullptr && (lit = chained(node)) != nullptr) {
+                if(l.chain == npos)
+                    l.chain = (index_type)text.size();
+                else
+                    text.pop_back();    // continue the chain over the terminator
+                const char* word = binbag_get(words, lit->id);
+                text.push_back('/');
+                text.insert(text.end(), word, word + strlen(word) + 1);
+                node = lit->nextNode;
+            }
+            return node;
+        }
+
+        /// \brief Copy the text of a literal into the text block
+        /// Words are only stored once even if they are a literal of many nodes.
+        index_type addText(long id, std::vector<index_type>& offsets) {
+            if(id >= (long)offsets.size())
+                offsets.resize(id+1, npos);
+            if(offsets[id] == npos) {
+                const char* word = binbag_get(words, id);
+                offsets[id] = (index_type)text.size();
+                text.insert(text.end(), word, word + strlen(word) + 1);
+            }
+            return offsets[id];
+        }
+
+        /// \brief Build the hash table for the literals of a node
+        void addBuckets(Node& node) {
+            node.bucket_bits = 1;
+            while(((index_type)1 << node.bucket_bits) < 2*(index_type)node.nliterals)
+                node.bucket_bits++;     // keep load factor at or below 50%
+
+            index_type mask = ((index_type)1 << node.bucket_bits) - 1;
+            node.buckets = (index_type)buckets.size();
+            buckets.resize(buckets.size() + mask + 1, npos);
+            index_type* table = &buckets[node.buckets];
+            for(index_type i = node.literals, _i = node.literals + node.nliterals; i < _i; i++) {
+                index_type b = literals[i].hash & mask;
+                while(table[b] != npos)
+                    b = (b+1) & mask;
+                table[b] = i;
+            }
+        }
+
+        /// \brief Build the prefix block for the literals of a node
+        void addPrefixes(Node& node) {
+            node.prefixed = true;
+            node.buckets = (index_type)prefixes.size();
+            prefixes.resize(prefixes.size() + node.nliterals * prefix_size, 0);
+            uint8_t* block = &prefixes[node.buckets];
+            for(index_type i = 0; i < node.nliterals; i++) {
+                const char* word = &text[literals[node.literals + i].text];
+                for(size_t k=0; k < prefix_size && word[k] != 0; k++)
+                    block[i*prefix_size + k] = (uint8_t)tolower((unsigned char)word[k]);
+            }
+        }
+
+        /// \brief Lays out the graph starting at root in breadth-first order
+        /// The sources array doubles as the BFS queue, a node gets its index when it is enqueued and the node entries
+        /// are filled in as the queue is consumed, so table nodes are in the same order as sources.
+        void compile(NodeData* root) {
+            std::vector<index_type> offsets;        // offset into text block of each word in the literal index
+            nshared = 0;
+            share(root);
+            enqueue(root);
+            for(size_t i=0; i < sources.size(); i++) {
+                NodeData* src = sources[i];
+                Node node;
+
+                // literals of a node are kept together
+                node.literals = (index_type)literals.size();
+                node.nliterals = 0;
+                node.buckets = npos;
+                node.bucket_bits = 0;
+                node.prefixed = false;
+                for(auto lit = src->literals; lit != nullptr && lit->isValid(); lit = lit->next) {
+                    if(lit->isNumeric)
+                        continue;   // numeric literals are never matched when resolving
+                    Literal l;
+                    l.text = addText(lit->id, offsets);
+                    l.hash = hash_nocase(&text[l.text]);
+                    l.word = lit->word;
+                    l.length = lit->length;
+                    l.next = enqueue(lit->nextNode);
+                    NodeData* end = addChain(lit->nextNode, l);
+                    if(l.chain != npos)
+                        l.skip = enqueue(end);
+                    literals.push_back(l);
+                    if(counting)
+                        origins.push_back(lit);
+                    node.nliterals++;
+                }
+                if(node.nliterals >= hash_threshold) {
+                    if(strategy == PrefixMatch && node.nliterals <= prefix_limit)
+                        addPrefixes(node);
+                    else
+                        addBuckets(node);
+                }
+
+                // a single argument type can be linked by more than one of the token types
+                node.numeric = (src->numeric != nullptr) ? addArgument(src->numeric) : npos;
+                node.string = (src->string == nullptr)
+                        ? npos
+                        : (src->string == src->numeric)
+                          ? node.numeric
+                          : addArgument(src->string);
+                node.boolean = (src->boolean == nullptr)
+                        ? npos
+                        : (src->boolean == src->numeric)
+                          ? node.numeric
+                          : (src->boolean == src->string)
+                            ? node.string
+                            : addArgument(src->boolean);
+
+                node.wild = enqueue(src->wild);
+                node.reachable = src->reachable;
+                nodes.push_back(node);
+            }
+
+            nodes.shrink_to_fit();
+            literals.shrink_to_fit();
+            arguments.shrink_to_fit();
+            buckets.shrink_to_fit();
+            text.shrink_to_fit();
+            prefixes.shrink_to_fit();
+            sources.shrink_to_fit();
+            origins.shrink_to_fit();
+            std::unordered_map<NodeData*, index_type>().swap(queued);
+            std::unordered_map<NodeData*, NodeData*>().swap(standins);
+        }
+    };
+
+    template<class TNodeData> constexpr typename FrozenTable<TNodeData>::index_type FrozenTable<TNodeData>::npos;
+    template<class TNodeData> constexpr typename FrozenTable<TNodeData>::count_type FrozenTable<TNodeData>::hash_threshold;
+    template<class TNodeData> constexpr typename FrozenTable<TNodeData>::count_type FrozenTable<TNodeData>::prefix_limit;
+    template<class TNodeData> constexpr size_t FrozenTable<TNodeData>::prefix_size;
+
+}
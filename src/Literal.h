@@ -4,23 +4,41 @@
 
 #pragma once
 
+#include "Token.h"
+
+#include <atomic>
+
 namespace Rest {
 
     class Literal {
     public:
-        Literal() : id(0), isNumeric(false) {}
-        Literal(ssize_t _id, bool _isNumeric = false) : id(_id), isNumeric(_isNumeric) {}
+        Literal() : id(0), word(0), length(0), isNumeric(false), hits(0) {}
+        Literal(ssize_t _id, bool _isNumeric = false) : id(_id), word(0), length(0), isNumeric(_isNumeric), hits(0) {}
 
-        Literal(const Literal& copy) : id(copy.id), isNumeric(copy.isNumeric) {}
+        Literal(const Literal& copy)
+            : id(copy.id), word(copy.word), length(copy.length), isNumeric(copy.isNumeric),
+              hits(copy.hits.load(std::memory_order_relaxed)) {}
 
         // if this argument is matched, the value is added to the request object under this field name
         // this id usually indicates an index into an array of text terms (binbag)
         ssize_t id;
 
+        // short words are also kept inline, packed by fold_word(), so resolving can match them without the index.
+        // length is zero for numeric literals and words longer than WORD_INLINE_SIZE.
+        uint64_t word;
+        uint8_t length;
+
         // true if the id should be take as a numeric value and not a string index ID
         bool isNumeric;
 
+        // number of times the literal matched while the Endpoints were counting hits, see Endpoints::adapt()
+        // concurrent resolves may count at the same time, the count only needs to be roughly right so it is relaxed
+        std::atomic<uint32_t> hits;
+
         inline bool isValid() { return isNumeric || (id >= 0); }
+
+        /// \brief True if the literal is kept inline and equals the word of the token
+        inline bool matches(const Token& t) const { return length == t.len && word == t.word; }
     };
 
 } // ns: Rest
\ No newline at end of file
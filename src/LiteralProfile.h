@@ -0,0 +1,184 @@
+//
+// Created by Colin MacKenzie on 2019-06-16.
+//
+
+#pragma once
+
+#include "Token.h"
+
+#include <vector>
+#include <string>
+#include <unordered_set>
+#include <algorithm>
+#include <stdlib.h>
+
+namespace Rest {
+
+    /// \brief Orders the literals of a node graph by how often they match
+    /// While Endpoints counts hits (see Endpoints::adapt()) every literal edge records how many times it matched a
+    /// segment of a Uri. reorder() sorts the literals of every node so the busiest are compared first, and the counts
+    /// can be saved as a profile and loaded again at startup so the layout survives a restart.
+    ///
+    /// A profile is plain text with one line per literal that was hit, its path from the root and its count separated
+    /// by a tab. Arguments in the path are written as :name and wildcards as *, for example "api/dev/:id/status\t120".
+    template<class TNodeData>
+    class LiteralProfile {
+    public:
+        using NodeData = TNodeData;
+        using LiteralType = typename NodeData::LiteralType;
+        using ArgumentType = typename NodeData::ArgumentType;
+
+        /// \brief Sort the literals of every node below root by hits, busiest first
+        /// The sort is stable so literals with the same count keep the order they were declared in. Counts are
+        /// halved afterwards so the order follows changes in traffic.
+        static void reorder(NodeData* root) {
+            std::vector<LiteralType*> list;
+            each(root, [&list](NodeData* node) {
+                list.clear();
+                LiteralType* lit = node->literals;
+                for(; lit != nullptr && lit->isValid(); lit = lit->next)
+                    list.push_back(lit);
+                if(list.empty())
+                    return;
+
+                std::stable_sort(list.begin(), list.end(), [](const LiteralType* a, const LiteralType* b) {
+                    return a->hits > b->hits;
+                });
+
+                // relink, anything after the valid literals stays at the end of the list
+                for(size_t i=0; i < list.size(); i++) {
+                    list[i]->next = (i+1 < list.size()) ? list[i+1] : lit;
+                    list[i]->hits = list[i]->hits / 2;
+                }
+                node->literals = list[0];
+            });
+        }
+
+        /// \brief Returns the hit counts of the literals below root as a profile
+        /// The ids of the literals are words in dictionary.
+        static std::string save(NodeData* root, binbag* dictionary) {
+            std::string profile, path;
+            save(root, dictionary, path, profile);
+            return profile;
+        }
+
+        /// \brief Set the hit counts of the literals below root from a profile
+        /// Lines for paths that no longer exist are skipped. Returns the number of literals that were set.
+        static size_t load(NodeData* root, binbag* dictionary, const char* profile) {
+            size_t loaded = 0;
+            const char* line = profile;
+            while(line != nullptr && *line != 0) {
+                const char* eol = strchr(line, '\n');
+                if(eol == nullptr)
+                    eol = line + strlen(line);
+                const char* tab = (const char*)memchr(line, '\t', eol - line);
+                if(tab != nullptr) {
+                    LiteralType* lit = find(root, dictionary, line, tab);
+                    if(lit != nullptr) {
+                        lit->hits = (uint32_t)strtoul(tab + 1, nullptr, 10);
+                        loaded++;
+                    }
+                }
+                line = (*eol != 0) ? eol + 1 : eol;
+            }
+            return loaded;
+        }
+
+    protected:
+        /// \brief Call f for every node below root
+        template<class F>
+        static void each(NodeData* root, F f) {
+            std::unordered_set<NodeData*> visited;
+            std::vector<NodeData*> stack;
+            stack.push_back(root);
+            while(!stack.empty()) {
+                NodeData* node = stack.back();
+                stack.pop_back();
+                if(node == nullptr || !visited.insert(node).second)
+                    continue;
+                f(node);
+                for(auto lit = node->literals; lit != nullptr && lit->isValid(); lit = lit->next)
+                    stack.push_back(lit->nextNode);
+                for(ArgumentType* arg: { node->numeric, node->string, node->boolean })
+                    if(arg != nullptr)
+                        stack.push_back(arg->nextNode);
+                stack.push_back(node->wild);
+            }
+        }
+
+        static void save(NodeData* node, binbag* dictionary, std::string& path, std::string& profile) {
+            if(node == nullptr)
+                return;
+            size_t len = path.size();
+            auto segment = [&path,len](const char* prefix, const char* word) {
+                path.resize(len);
+                if(len > 0)
+                    path += '/';
+                path += prefix;
+                path += word;
+            };
+
+            for(auto lit = node->literals; lit != nullptr && lit->isValid(); lit = lit->next) {
+                if(lit->isNumeric)
+                    continue;
+                segment("", binbag_get(dictionary, lit->id));
+                if(lit->hits > 0)
+                    profile += path + '\t' + std::to_string(lit->hits) + '\n';
+                save(lit->nextNode, dictionary, path, profile);
+            }
+
+            ArgumentType* args[] = { node->numeric, node->string, node->boolean };
+            for(int i=0; i < 3; i++) {
+                if(args[i] == nullptr || (i > 0 && args[i] == args[0]) || (i > 1 && args[i] == args[1]))
+                    continue;   // argument shared by more than one token type
+                segment(":", binbag_get(literals_index, args[i]->nameIndex()));
+                save(args[i]->nextNode, dictionary, path, profile);
+            }
+
+            if(node->wild != nullptr) {
+                segment("*", "");
+                save(node->wild, dictionary, path, profile);
+            }
+            path.resize(len);
+        }
+
+        /// \brief Find the literal at the end of a profile path
+        static LiteralType* find(NodeData* node, binbag* dictionary, const char* path, const char* end) {
+            while(node != nullptr && path < end) {
+                const char* sep = (const char*)memchr(path, '/', end - path);
+                if(sep == nullptr)
+                    sep = end;
+                size_t n = sep - path;
+                NodeData* next = nullptr;
+
+                if(n == 1 && *path == '*') {
+                    next = node->wild;
+                } else if(n > 0 && *path == ':') {
+                    for(ArgumentType* arg: { node->numeric, node->string, node->boolean }) {
+                        const char* name = (arg != nullptr) ? binbag_get(literals_index, arg->nameIndex()) : nullptr;
+                        if(name != nullptr && strncmp(name, path + 1, n - 1) == 0 && name[n - 1] == 0) {
+                            next = arg->nextNode;
+                            break;
+                        }
+                    }
+                } else {
+                    for(auto lit = node->literals; lit != nullptr && lit->isValid(); lit = lit->next) {
+                        if(lit->isNumeric)
+                            continue;
+                        const char* word = binbag_get(dictionary, lit->id);
+                        if(strncasecmp(word, path, n) == 0 && word[n] == 0) {
+                            if(sep == end)
+                                return lit;
+                            next = lit->nextNode;
+                            break;
+                        }
+                    }
+                }
+                node = next;
+                path = (sep < end) ? sep + 1 : end;
+            }
+            return nullptr;
+        }
+    };
+
+}
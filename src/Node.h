@@ -45,46 +45,94 @@ namespace Rest {
 
         External *externals;
 
-        // if we are at the end of the URI then we can pass to one of the http verb handlers
-        HandlerType GET, POST, PUT, PATCH, DELETE, OPTIONS;
+        // names and declared typemasks of the arguments of requests that resolve to this node, in the order they
+        // appear in the Uri
+        const uint32_t* argnames;
+        const uint16_t* argtypes;
+        unsigned short nargnames;
+
+        // if we are at the end of the URI then we can pass to one of the http verb handlers. Bit n of methods is set
+        // if there is a handler for HttpMethod n, the handlers array holds one handler per bit set in method order.
+        uint16_t methods;
+        HandlerType* handlers;
+
+        // methods that have a handler at this node or any node below it, so resolving can give up as soon as the
+        // requested method cannot be reached. Externals may handle any method. Kept up to date by
+        // Endpoints::handlersChanged().
+        uint16_t reachable;
 
         inline NodeData() : literals(nullptr), string(nullptr), numeric(nullptr), boolean(nullptr), wild(nullptr),
-                            GET(nullptr), POST(nullptr), PUT(nullptr), PATCH(nullptr), DELETE(nullptr), OPTIONS(nullptr)
+                            externals(nullptr), argnames(nullptr), argtypes(nullptr), nargnames(0),
+                            methods(0), handlers(nullptr), reachable(0)
         {}
 
         inline bool isSet(const HandlerType& h) const { return h != nullptr; }
 
-        NodeData::HandlerType& handle(HttpMethod method) {
-            // get a pointer to the Handler member variable from the node
-            switch(method) {
-                case HttpGet: return GET;
-                case HttpPost: return POST;
-                case HttpPut: return PUT;
-                case HttpPatch: return PATCH;
-                case HttpDelete: return DELETE;
-                case HttpOptions: return OPTIONS;
-                default: return GET;
-            }
+        /// \brief bit of a method in the methods mask, or 0 if the method cannot have a handler
+        static inline uint16_t methodBit(HttpMethod method) {
+            return (method > HttpMethodAny && method <= HttpMethodMax) ? (uint16_t)(1u << method) : (uint16_t)0;
+        }
+
+        /// \brief bit of the method a request is handled by, requests for any method are handled as GET
+        static inline uint16_t requestBit(HttpMethod method) {
+            return methodBit((method == HttpMethodAny) ? HttpGet : method);
         }
 
-        void attach(HttpMethod method, const NodeData::HandlerType& handler) {
-            // get a pointer to the Handler member variable from the node
-            switch(method) {
-                case HttpGet: GET = handler; break;
-                case HttpPost: POST = handler; break;
-                case HttpPut: PUT = handler; break;
-                case HttpPatch: PATCH = handler; break;
-                case HttpDelete: DELETE = handler; break;
-                case HttpOptions: OPTIONS = handler; break;
-                case HttpMethodAny:
-                    if(!isSet(GET)) GET = handler;
-                    if(!isSet(POST)) POST = handler;
-                    if(!isSet(PUT)) PUT = handler;
-                    if(!isSet(PATCH)) PATCH = handler;
-                    if(!isSet(DELETE)) DELETE = handler;
-                    if(!isSet(OPTIONS)) OPTIONS = handler;
-                    break;
+        /// \brief Returns the handler for a http verb, or nullptr if there is none
+        /// The handler is found by counting the methods with a lower bit than the requested one.
+        const HandlerType* handle(HttpMethod method) const {
+            uint16_t bit = requestBit(method);
+            return ((methods & bit) != 0)
+                   ? &handlers[__builtin_popcount(methods & (bit - 1))]
+                   : nullptr;
+        }
+
+        /// \brief Attach a handler to one http verb, or to every standard verb without a handler for HttpMethodAny
+        /// Adding a verb copies the handlers into a new array from the pool, attaching a null handler removes it.
+        void attach(HttpMethod method, const NodeData::HandlerType& handler, PagedPool& pool) {
+            uint16_t bits = (method == HttpMethodAny)
+                            ? (uint16_t)((methodBit(HttpCustom) - 1) & ~(methodBit(HttpGet) - 1) & ~methods)
+                            : methodBit(method);
+            if(bits == 0)
+                return;
+
+            uint16_t mask = isSet(handler)
+                            ? (uint16_t)(methods | bits)
+                            : (uint16_t)(methods & ~bits);
+            if(mask == methods && isSet(handler)) {
+                // replacing the handler of a verb, the array stays the same size
+                handlers[__builtin_popcount(methods & (bits - 1))] = handler;
+                return;
             }
+
+            HandlerType* table = (mask != 0)
+                    ? (HandlerType*)pool.allocate(__builtin_popcount(mask) * sizeof(HandlerType), alignof(HandlerType))
+                    : nullptr;
+            HandlerType* h = table;
+            for(uint16_t bit = methodBit(HttpGet); bit != 0 && bit <= mask; bit <<= 1) {
+                if((mask & bit) != 0)
+                    new(h++) HandlerType(((bits & bit) != 0)
+                                         ? handler
+                                         : handlers[__builtin_popcount(methods & (bit - 1))]);
+            }
+            methods = mask;
+            handlers = table;
+        }
+
+        /// \brief Recompute the reachable methods of this node and every node below it
+        uint16_t updateReachable() {
+            uint16_t r = (externals != nullptr)
+                         ? (uint16_t)0xffff
+                         : methods;
+            for(auto lit = literals; lit != nullptr && lit->isValid(); lit = lit->next)
+                if(lit->nextNode != nullptr)
+                    r |= lit->nextNode->updateReachable();
+            for(ArgumentType* arg: { numeric, string, boolean })
+                if(arg != nullptr && arg->nextNode != nullptr)
+                    r |= arg->nextNode->updateReachable();
+            if(wild != nullptr)
+                r |= wild->updateReachable();
+            return reachable = r;
         }
     };
 
@@ -110,7 +158,9 @@ namespace Rest {
 
             inline Request() : handler(nullptr) {}
             inline Request(HttpMethod _method, const char* _uri, int _status=0) : UriRequest(_method, _uri, _status), handler(nullptr) {}
+            inline Request(HttpMethod _method, const char* _uri, PagedPool& arena) : UriRequest(_method, _uri, arena), handler(nullptr) {}
             inline Request(const Request& copy) : UriRequest(copy), handler(copy.handler) {}
+            inline Request(Request&& move) noexcept : UriRequest(std::move(move)), handler(std::move(move.handler)) {}
 
             inline Request(const UriRequest& req) : UriRequest(req), handler(nullptr) {}
 
@@ -120,6 +170,12 @@ namespace Rest {
                 return *this;
             }
 
+            Request& operator=(Request&& move) noexcept {
+                UriRequest::operator=(std::move(move));
+                handler = std::move(move.handler);
+                return *this;
+            }
+
             inline explicit operator bool() const { return status==UriMatched && handler!=nullptr; }
         };
 
@@ -153,6 +209,7 @@ namespace Rest {
                 _node->externals->append(ext);
             else
                 _node->externals = ext;
+            _endpoints->handlersChanged(_node);
         }
 
         // resolve an external Endpoints collection and apply the instance object to the resolve handler
@@ -165,8 +222,10 @@ namespace Rest {
                    [&inst,&ep](ParserState& lhs_request) -> Handler {
                        typename EP::Node rhs_node = ep.getRoot();
 
-                       ParserState rhs_request(lhs_request);
-                       typename EP::Handler handler = rhs_node.resolve(rhs_request);
+                       auto checkpoint = lhs_request.checkpoint();
+                       typename EP::Handler handler = rhs_node.resolve(lhs_request);
+                       if(handler==nullptr)
+                           lhs_request.rollback(checkpoint);
                        return (handler!=nullptr)
                             ? std::bind(handler, inst, std::placeholders::_1)    // todo: what if there is more than 1 argument in handler?
                             : Handler();
@@ -181,13 +240,15 @@ namespace Rest {
         typename EP::Node with(I& inst) { // here klass is the handler's class type
             // store the klass reference and endpoints reference together using std::shared_ptr which gets stored in
             // the lambda class type.
-            auto ep = std::make_shared<EP>();
+            auto ep = std::make_shared<EP>(_endpoints->getDictionary());   // words are shared with the parent
             otherwise(
                     [&inst, ep](ParserState& lhs_request) -> Handler {
                         typename EP::Node rhs_node = ep->getRoot();
 
-                        ParserState rhs_request(lhs_request);
-                        typename EP::Handler handler = rhs_node.resolve(rhs_request);
+                        auto checkpoint = lhs_request.checkpoint();
+                        typename EP::Handler handler = rhs_node.resolve(lhs_request);
+                        if(handler==nullptr)
+                            lhs_request.rollback(checkpoint);
                         return (handler!=nullptr)
                                ? std::bind(handler, inst, std::placeholders::_1)    // todo: what if there is more than 1 argument in handler?
                                : Handler();
@@ -204,22 +265,25 @@ namespace Rest {
         typename EP::Node with( std::function< I&(Rest::UriRequest&) > resolver) { // here klass is the handler's class type
             // store the klass reference and endpoints reference together using std::shared_ptr which gets stored in
             // the lambda class type.
-            auto ep = std::make_shared<EP>();
+            auto ep = std::make_shared<EP>(_endpoints->getDictionary());
             otherwise(
                     // this lambda is the 'external', it holds the internally stored Endpoints object, along with the
                     // resolver function and when invoked will call resolve() on the this internal Endpoints to get
                     // the instance handler and convert it to static using the instance resolver function.
                     [resolver, ep](ParserState& lhs_request) -> Handler {
                         typename EP::Node rhs_node = ep->getRoot();
-                        ParserState rhs_request(lhs_request);
+                        auto checkpoint = lhs_request.checkpoint();
 
                         // try to resolve the rest of the endpoint Uri and get an instance handler
-                        typename EP::Handler handler = rhs_node.resolve(rhs_request);
+                        typename EP::Handler handler = rhs_node.resolve(lhs_request);
                         if(handler!=nullptr) {
                             // resolved an instance handler, now call the instance resolver to get an object instance (this pointer)
-                            I& inst = resolver(rhs_request.request);
-                            if(!rhs_request.request.isSuccessful() || &inst == nullptr ) {
-                                lhs_request.request.status = rhs_request.request.status;
+                            I& inst = resolver(lhs_request.request);
+                            if(!lhs_request.request.isSuccessful() || &inst == nullptr ) {
+                                // roll back but keep any error status the instance callback set
+                                int status = lhs_request.request.status;
+                                lhs_request.rollback(checkpoint);
+                                lhs_request.request.status = status;
                                 return Handler();   // failed to resolve due to instance callback
                             }
 
@@ -227,7 +291,10 @@ namespace Rest {
                             return std::bind(handler, inst,
                                       std::placeholders::_1);    // todo: what if there is more than 1 argument in handler?
                         }
-                        else return Handler();  // external did not resolve handler
+                        else {
+                            lhs_request.rollback(checkpoint);
+                            return Handler();  // external did not resolve handler
+                        }
                     }
             );
 
@@ -242,22 +309,25 @@ namespace Rest {
         typename EP::Node with( std::function< I*(Rest::UriRequest&) > resolver) { // here klass is the handler's class type
             // store the klass reference and endpoints reference together using std::shared_ptr which gets stored in
             // the lambda class type.
-            auto ep = std::make_shared<EP>();
+            auto ep = std::make_shared<EP>(_endpoints->getDictionary());
             otherwise(
                     // this lambda is the 'external', it holds the internally stored Endpoints object, along with the
                     // resolver function and when invoked will call resolve() on the this internal Endpoints to get
                     // the instance handler and convert it to static using the instance resolver function.
                     [resolver, ep](ParserState& lhs_request) -> Handler {
                         typename EP::Node rhs_node = ep->getRoot();
-                        ParserState rhs_request(lhs_request);
+                        auto checkpoint = lhs_request.checkpoint();
 
                         // try to resolve the rest of the endpoint Uri and get an instance handler
-                        typename EP::Handler handler = rhs_node.resolve(rhs_request);
+                        typename EP::Handler handler = rhs_node.resolve(lhs_request);
                         if(handler!=nullptr) {
                             // resolved an instance handler, now call the instance resolver to get an object instance (this pointer)
-                            I* inst = resolver(rhs_request.request);
-                            if(inst == nullptr || !rhs_request.request.isSuccessful()) {
-                                lhs_request.request.status = rhs_request.request.status;
+                            I* inst = resolver(lhs_request.request);
+                            if(inst == nullptr || !lhs_request.request.isSuccessful()) {
+                                // roll back but keep any error status the instance callback set
+                                int status = lhs_request.request.status;
+                                lhs_request.rollback(checkpoint);
+                                lhs_request.request.status = status;
                                 return Handler();   // failed to resolve due to instance callback
                             }
 
@@ -265,7 +335,10 @@ namespace Rest {
                             return std::bind(handler, inst,
                                              std::placeholders::_1);    // todo: what if there is more than 1 argument in handler?
                         }
-                        else return Handler();  // external did not resolve handler
+                        else {
+                            lhs_request.rollback(checkpoint);
+                            return Handler();  // external did not resolve handler
+                        }
                     }
             );
 
@@ -280,22 +353,25 @@ namespace Rest {
         typename EP::Node with( std::function< const I*(Rest::UriRequest&) > resolver) { // here klass is the handler's class type
             // store the klass reference and endpoints reference together using std::shared_ptr which gets stored in
             // the lambda class type.
-            auto ep = std::make_shared<EP>();
+            auto ep = std::make_shared<EP>(_endpoints->getDictionary());
             otherwise(
                     // this lambda is the 'external', it holds the internally stored Endpoints object, along with the
                     // resolver function and when invoked will call resolve() on the this internal Endpoints to get
                     // the instance handler and convert it to static using the instance resolver function.
                     [resolver, ep](ParserState& lhs_request) -> Handler {
                         typename EP::Node rhs_node = ep->getRoot();
-                        ParserState rhs_request(lhs_request);
+                        auto checkpoint = lhs_request.checkpoint();
 
                         // try to resolve the rest of the endpoint Uri and get an instance handler
-                        typename EP::Handler handler = rhs_node.resolve(rhs_request);
+                        typename EP::Handler handler = rhs_node.resolve(lhs_request);
                         if(handler!=nullptr) {
                             // resolved an instance handler, now call the instance resolver to get an object instance (this pointer)
-                            const I* inst = resolver(rhs_request.request);
-                            if(inst == nullptr || !rhs_request.request.isSuccessful()) {
-                                lhs_request.request.status = rhs_request.request.status;
+                            const I* inst = resolver(lhs_request.request);
+                            if(inst == nullptr || !lhs_request.request.isSuccessful()) {
+                                // roll back but keep any error status the instance callback set
+                                int status = lhs_request.request.status;
+                                lhs_request.rollback(checkpoint);
+                                lhs_request.request.status = status;
                                 return Handler();   // failed to resolve due to instance callback
                             }
 
@@ -303,7 +379,10 @@ namespace Rest {
                             return std::bind(handler, inst,
                                              std::placeholders::_1);    // todo: what if there is more than 1 argument in handler?
                         }
-                        else return Handler();  // external did not resolve handler
+                        else {
+                            lhs_request.rollback(checkpoint);
+                            return Handler();  // external did not resolve handler
+                        }
                     }
             );
 
@@ -321,10 +400,13 @@ namespace Rest {
             otherwise(
                     [&ep](ParserState& lhs_request) -> Handler {
                         typename TEndpoints::Node rhs_node = ep.getRoot();
-                        ParserState rhs_request(lhs_request);
+                        auto checkpoint = lhs_request.checkpoint();
 
                         // try to resolve the rest of the endpoint Uri
-                        return rhs_node.resolve(rhs_request);
+                        Handler handler = rhs_node.resolve(lhs_request);
+                        if(handler==nullptr)
+                            lhs_request.rollback(checkpoint);
+                        return handler;
                     }
             );
             return ep.getRoot();
@@ -349,6 +431,7 @@ namespace Rest {
         template<typename H> inline Node& POST(H handler) { attach(HttpPost, handler); return *this; }
         template<typename H> inline Node& DELETE(H handler) { attach(HttpDelete, handler); return *this; }
         template<typename H> inline Node& OPTIONS(H handler) { attach(HttpOptions, handler); return *this; }
+        template<typename H> inline Node& HEAD(H handler) { attach(HttpHead, handler); return *this; }
         template<typename H> inline Node& ANY(H handler) { attach(HttpMethodAny, handler); return *this; }
 
         template<typename H> inline Node& GET(const char* expr, H handler) { attach(expr, HttpGet, handler); return *this; }
@@ -357,11 +440,39 @@ namespace Rest {
         template<typename H> inline Node& POST(const char* expr, H handler) { attach(expr, HttpPost, handler); return *this; }
         template<typename H> inline Node& DELETE(const char* expr, H handler) { attach(expr, HttpDelete, handler); return *this; }
         template<typename H> inline Node& OPTIONS(const char* expr, H handler) { attach(expr, HttpOptions, handler); return *this; }
+        template<typename H> inline Node& HEAD(const char* expr, H handler) { attach(expr, HttpHead, handler); return *this; }
         template<typename H> inline Node& ANY(const char* expr, H handler) { attach(expr, HttpMethodAny, handler); return *this; }
 
         inline void attach(HttpMethod method, Handler handler ) {
-            if(_node!= nullptr)
-                _node->attach(method, handler);
+            if(_node!= nullptr) {
+                _node->attach(method, handler, _endpoints->pool);
+                _endpoints->handlersChanged(_node);
+            }
+        }
+
+        /// \brief Attach a typed handler that receives the Uri arguments as parameters
+        /// The handler takes the request followed by a parameter for each argument of the endpoint, in Uri order, for
+        /// example int(Request&, long id, long n) for "dev/:id(integer)/ch/:n(integer)". Each parameter must be able to
+        /// hold every type declared for its argument, otherwise the handler is not attached and the node records an
+        /// InvalidParameterType exception. A different number of parameters is an InvalidHandler exception.
+        template<typename R, typename TRequest, typename... TArgs>
+        typename std::enable_if< (sizeof...(TArgs) > 0 && handler_arity<Handler>::value == 1) >::type
+        attach(HttpMethod method, R(*handler)(TRequest&, TArgs...) ) {
+            static const uint16_t masks[] = { ArgumentValue<TArgs>::mask... };
+            if(_node == nullptr)
+                return;
+            if(_node->nargnames != sizeof...(TArgs)) {
+                _exception = InvalidHandler;
+                return;
+            }
+            for(unsigned short i=0; i < _node->nargnames; i++) {
+                if((_node->argtypes[i] & ~masks[i]) != 0) {
+                    _exception = InvalidParameterType;
+                    return;
+                }
+            }
+            _node->attach(method, Handler(TypedHandler<R, TRequest, TArgs...>(handler)), _endpoints->pool);
+            _endpoints->handlersChanged(_node);
         }
 
         template<class HandlerT>
@@ -386,9 +497,12 @@ namespace Rest {
                 // change to expression from absolute root node
                 return _endpoints->getRoot().on(endpoint_expression+1);
 
+            // the frozen table would no longer match the node graph
+            _endpoints->thaw();
+
             // create new parser state
-            ParserState ev( UriRequest(HttpMethodAny, endpoint_expression) );
-            ev.mode = ParserState::expand;         // tell the parser we are adding this endpoint
+            ParserState ev( UriRequest(HttpMethodAny, endpoint_expression), ParserState::expand, nullptr,
+                    _endpoints->dictionary.words() );  // tell the parser we are adding this endpoint
 
             // parse the Uri expression
             Parser parser(_node, _endpoints);
@@ -399,48 +513,116 @@ namespace Rest {
                 if(ev.nargs > _endpoints->maxUriArgs)
                     _endpoints->maxUriArgs = ev.nargs;
 
+                // record the argument names and types of a new endpoint, following on from any arguments before
+                // this node
+                NodeData* context = parser.context;
+                size_t nargs = _node->nargnames + ev.request.args.count();
+                if(context->argnames == nullptr && nargs > 0) {
+                    uint32_t* names = _endpoints->newArgumentNames(nargs);
+                    uint16_t* types = _endpoints->newArgumentTypes(nargs);
+                    std::copy(_node->argnames, _node->argnames + _node->nargnames, names);
+                    std::copy(_node->argtypes, _node->argtypes + _node->nargnames, types);
+                    for(size_t i=_node->nargnames; i < nargs; i++) {
+                        const Argument& arg = ev.request.args[(int)(i - _node->nargnames)];
+                        names[i] = arg.nameId();
+                        types[i] = (uint16_t)arg.ul;
+                    }
+                    context->argnames = names;
+                    context->argtypes = types;
+                    context->nargnames = (unsigned short)nargs;
+                }
+                _endpoints->handlersChanged(context);
+
                 // attach the handler to this endpoint
-                return Node(_endpoints, parser.context);
+                return Node(_endpoints, context);
+            }
+        }
+
+        /// \brief Position of a named argument in requests that resolve to this endpoint
+        /// Look the position up once after declaring the endpoint, then fetch the argument in the handler by index
+        /// instead of by name. Positions count from the root of the Endpoints the endpoint was declared in, so for
+        /// endpoints reached through with() the arguments of the parent come first. Returns -1 if there is no argument
+        /// by that name.
+        int position(const ArgumentName& name) const {
+            if(_node != nullptr) {
+                for(unsigned short i=0; i < _node->nargnames; i++)
+                    if(_node->argnames[i] == name.id)
+                        return i;
             }
+            return -1;
         }
 
+        inline int position(const char* name) const { return position(ArgumentName(name)); }
+
         Request resolve(HttpMethod method, const char* uri) {
             Request request(method, uri);
             resolve(request);
             return request;
         }
 
-        bool resolve(Request& request) {
+        /// \brief Resolve a Uri that is not null terminated
+        /// Only the first length characters of uri are read, and resolving stops early at the query string if there is
+        /// one. The uri of the returned request points into the given buffer, which is not null terminated either.
+        Request resolve(HttpMethod method, const char* uri, size_t length) {
+            Request request(method, uri);
+            resolve(request, uri + length);
+            return request;
+        }
+
+        /// \brief Resolve the Uri of a request
+        /// The request Uri must be null terminated unless uri_end is given.
+        bool resolve(Request& request, const char* uri_end = nullptr) {
+            if(_endpoints->adaptInterval != 0)
+                _endpoints->adaptResolves.fetch_add(1, std::memory_order_relaxed);
+
+            // most requests are for endpoints without arguments, these are found in one probe of the static routes
+            if(_node == _endpoints->ep_head) {
+                NodeData* node = _endpoints->routes.find(request.uri, uri_end);
+                const Handler* handler = (node != nullptr) ? node->handle(request.method) : nullptr;
+                if(handler != nullptr) {
+                    request.handler = *handler;
+                    request.status = UriMatched;
+                    return true;
+                }
+            }
 
-            // initialize new parser state
-            ParserState ev(request);
-            if (ev.state < 0)
-                return URL_FAIL_SYNTAX;
+            // initialize new parser state, the request arguments are moved in and back out again when done
+            ParserState ev(std::move(request), ParserState::resolve, uri_end);
+            if (ev.state < 0) {
+                request.args = std::move(ev.request.args);
+                request.status = URL_FAIL_SYNTAX;
+                return false;
+            }
             ev.mode = ParserState::resolve;
             ev.request.args.reserve(_endpoints->maxUriArgs);
 
             Handler h = resolve(ev);
-            request.args = ev.request.args; // todo: can we get rid of this Args copy?
+            request.args = std::move(ev.request.args);
             request.handler = h;
             request.status = ev.result;
+            request.allowed = ev.request.allowed;
             return ev.result >=0;
         }
 
         Handler resolve(ParserState& ev) {
             // parse the input
-            Parser parser(_node, _endpoints);
-            if((ev.result=parser.parse( &ev )) >=UriMatched) {
+            NodeData* context;
+            if((ev.result=parse( ev, context )) >=UriMatched) {
                 // successfully resolved the endpoint
-                Handler handler = parser.context->handle(ev.request.method);
+                const Handler* handler = context->handle(ev.request.method);
                 if(handler != nullptr)
-                    return handler;
+                    return *handler;
 
                 ev.result = NoHandler;
+                ev.request.allowed = context->methods;
+            } else if(ev.result == NoHandler) {
+                // gave up early, no endpoint below the last node matched handles the method
+                ev.request.allowed = context->reachable;
             }
 
-            if((ev.result == NoEndpoint || ev.result == NoHandler) && parser.context->externals != nullptr) {
+            if((ev.result == NoEndpoint || ev.result == NoHandler) && context->externals != nullptr) {
                 // try any externals
-                auto external = parser.context->externals;
+                auto external = context->externals;
                 while(external != nullptr) {
                     // call into the external
                     Handler h = (*external)(ev);
@@ -454,7 +636,8 @@ namespace Rest {
 
                     // if we have a handler then return success
                     if(h!=nullptr) {
-                        ev.result = UriMatched;
+                        if(ev.result < UriMatched)
+                            ev.result = UriMatched;     // keep UriMatchedWildcard from the external
                         return h;
                     }
 
@@ -470,6 +653,24 @@ namespace Rest {
         Endpoints* _endpoints;
         NodeData* _node;
         int _exception;
+
+        /// \brief Parse the input of a resolve starting at this node
+        /// Uses the frozen routing table when we are the root of a frozen Endpoints, otherwise walks the node graph.
+        /// On return, context is the last node matched.
+        ParseResult parse(ParserState& ev, NodeData*& context) {
+            ParseResult rv;
+            auto frozen = _endpoints->frozen;
+            if(frozen != nullptr && _node == _endpoints->ep_head) {
+                typename Endpoints::FrozenTable::index_type n = 0;
+                rv = frozen->resolve( &ev, n );
+                context = frozen->data(n);
+            } else {
+                Parser parser(_node, _endpoints);
+                rv = parser.parse( &ev );
+                context = parser.context;
+            }
+            return rv;
+        }
     };
 
 }
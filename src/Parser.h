@@ -59,26 +59,58 @@ namespace Rest {
         Arguments args;
         int status;
 
-        inline UriRequest() :  method(HttpMethodAny), uri(nullptr), status(0) {}
-        inline UriRequest(HttpMethod _method, const char* _uri, int _status=0) : method(_method), uri(_uri), status(_status) {}
-        inline UriRequest(const UriRequest& copy) : method(copy.method), uri(copy.uri), args(copy.args), status(copy.status) {}
+        // when status is NoHandler, a bit (1 << HttpMethod) for each method that could have been handled
+        uint16_t allowed;
+
+        inline UriRequest() :  method(HttpMethodAny), uri(nullptr), status(0), allowed(0) {}
+        inline UriRequest(HttpMethod _method, const char* _uri, int _status=0) : method(_method), uri(_uri), status(_status), allowed(0) {}
+
+        /// \brief A request whose arguments are allocated from a request arena
+        /// Resolving allocates the arguments and their string values from the arena, reset the arena once the request
+        /// is finished to release them all at once.
+        inline UriRequest(HttpMethod _method, const char* _uri, PagedPool& arena) : method(_method), uri(_uri), args(arena), status(0), allowed(0) {}
+        inline UriRequest(const UriRequest& copy) : method(copy.method), uri(copy.uri), args(copy.args), status(copy.status), allowed(copy.allowed) {}
+        inline UriRequest(UriRequest&& move) noexcept : method(move.method), uri(move.uri), args(std::move(move.args)), status(move.status), allowed(move.allowed) {}
 
         inline const Argument& operator[](size_t idx) const { return args.operator[](idx); }
         inline const Argument& operator[](const char* name) const { return args.operator[](name); }
+        inline const Argument& operator[](const ArgumentName& name) const { return args.operator[](name); }
 
         inline UriRequest& operator=(const UriRequest& copy) {
             method=copy.method;
             uri=copy.uri;
             args=copy.args;
             status=copy.status;
+            allowed=copy.allowed;
+            return *this;
+        }
+
+        inline UriRequest& operator=(UriRequest&& move) noexcept {
+            method=move.method;
+            uri=move.uri;
+            args=std::move(move.args);
+            status=move.status;
+            allowed=move.allowed;
             return *this;
         }
 
         virtual void abort(int code) { status = code; }
 
         inline bool isSuccessful() const { return status==0 || (status >=200 && status<300); }
+
+        /// \brief True if a request for the method could have been handled, use to build an Allow header for a 405
+        inline bool allows(HttpMethod m) const { return m <= HttpMethodMax && (allowed & (1u << m)) != 0; }
     };
 
+    /// \brief Position of the first argument a typed handler receives
+    /// An endpoint reached through Endpoints joined with with() gets the arguments of the parent first, so a typed
+    /// handler receives the last arity arguments, not counting the rest of the Uri a wildcard adds at the end.
+    template<class TRequest>
+    std::size_t typed_arguments_begin(const TRequest& request, std::size_t arity) {
+        std::size_t n = (std::size_t)request.args.count() - ((request.status == UriMatchedWildcard) ? 1 : 0);
+        return (n > arity) ? n - arity : 0;
+    }
+
     /// \brief Contains state for resolving or expanding a Url expression tree
     class ParserState {
     public:
@@ -87,30 +119,41 @@ namespace Rest {
             resolve = 2        // indicates we are resolving a URL to a defined handler
         } mode_e;
 
-        ParserState(const UriRequest& _request)
-                : mode(resolve), request(_request), state(expectPathPartOrSep),
+        /// \brief Start parsing the Uri of a request
+        /// The Uri must be null terminated unless _end is given, then the Uri ends at _end or the first null. When
+        /// expanding, the words of the expression are indexed in _dictionary (the literals index if not given).
+        ParserState(const UriRequest& _request, mode_e _mode = resolve, const char* _end = nullptr, binbag* _dictionary = nullptr)
+                : mode(_mode), request(_request), end(_end), dictionary(_dictionary), state(expectPathPartOrSep),
                   nargs(0), result(0)
         {
-            if(request.uri != nullptr) {
-                // scan first token
-                if (!t.scan(&request.uri, 1))
-                    goto bad_eval;
-                peek.scan(&request.uri, 1);
-            }
-            return;
-        bad_eval:
-            state = -1;
+            start();
+        }
+
+        /// \brief Start parsing the Uri of a request, taking over the request's arguments
+        ParserState(UriRequest&& _request, mode_e _mode = resolve, const char* _end = nullptr, binbag* _dictionary = nullptr)
+                : mode(_mode), request(std::move(_request)), end(_end), dictionary(_dictionary), state(expectPathPartOrSep),
+                  nargs(0), result(0)
+        {
+            start();
         }
 
         ParserState(const ParserState& copy)
-            : mode(copy.mode), request(copy.request), t(copy.t), peek(copy.peek), state(copy.state),
-              nargs(copy.nargs), result(copy.result)
+            : mode(copy.mode), request(copy.request), end(copy.end), dictionary(copy.dictionary), t(copy.t),
+              peek(copy.peek), state(copy.state), nargs(copy.nargs), result(copy.result)
+        {
+        }
+
+        ParserState(ParserState&& move) noexcept
+            : mode(move.mode), request(std::move(move.request)), end(move.end), dictionary(move.dictionary),
+              t(std::move(move.t)), peek(std::move(move.peek)), state(move.state), nargs(move.nargs), result(move.result)
         {
         }
 
         ParserState& operator=(const ParserState& copy) {
             mode = copy.mode;
             request = copy.request;
+            end = copy.end;
+            dictionary = copy.dictionary;
             t = copy.t;
             peek = copy.peek;
             state = copy.state;
@@ -119,6 +162,55 @@ namespace Rest {
             return *this;
         }
 
+        ParserState& operator=(ParserState&& move) noexcept {
+            mode = move.mode;
+            request = std::move(move.request);
+            end = move.end;
+            dictionary = move.dictionary;
+            t = std::move(move.t);
+            peek = std::move(move.peek);
+            state = move.state;
+            nargs = move.nargs;
+            result = move.result;
+            return *this;
+        }
+
+        /// \brief Position of the parser within the Uri
+        /// Before an external tries to resolve the rest of the Uri the position is saved, and if the external fails
+        /// the parser is rolled back so the next external can try from the same place. Only the number of arguments
+        /// is saved, rolling back drops any arguments the external added.
+        class Checkpoint {
+        public:
+            const char* uri;
+            Token t, peek;
+            int state;
+            int result;
+            int status;
+            short argc;
+        };
+
+        Checkpoint checkpoint() const {
+            Checkpoint cp;
+            cp.uri = request.uri;
+            cp.t = t;
+            cp.peek = peek;
+            cp.state = state;
+            cp.result = result;
+            cp.status = request.status;
+            cp.argc = request.args.count();
+            return cp;
+        }
+
+        void rollback(Checkpoint& cp) {
+            request.uri = cp.uri;
+            t.swap(cp.t);
+            peek.swap(cp.peek);
+            state = cp.state;
+            result = cp.result;
+            request.status = cp.status;
+            request.args.truncate(cp.argc);
+        }
+
     public:
         // indicates if we are parsing to resolve or to add an endpoint
         mode_e mode;
@@ -126,6 +218,12 @@ namespace Rest {
         // parser input string (gets eaten as parsing occurs)
         UriRequest request;
 
+        // end of the input string, or null if the input is null terminated
+        const char* end;
+
+        // where words of an expression are indexed when expanding, or null for the literals index
+        binbag* dictionary;
+
         // current token 't' and look-ahead token 'peek' pulled from the input string 'uri' (above)
         Token t, peek;
 
@@ -139,12 +237,31 @@ namespace Rest {
 
         // parse result
         int result;
+
+        /// \brief scan the first two tokens
+        void start() {
+            if(request.uri != nullptr) {
+                if (!t.scan(&request.uri, mode == expand, end, dictionary))
+                    state = -1;
+                else
+                    peek.scan(&request.uri, mode == expand, end, dictionary);
+            }
+        }
+
+        /// \brief Length of the input from p up to the end of the Uri
+        /// The Uri ends at end, a null or the start of the query string.
+        size_t remaining(const char* p) const {
+            const char* e = p;
+            while((end == nullptr || e < end) && *e != 0 && *e != '?')
+                e++;
+            return e - p;
+        }
     };
 
 
 #define GOTO_STATE(st) { ev->state = st; goto rescan; }
 #define NEXT_STATE(st) { ev->state = st; }
-#define SCAN { ev->t.clear(); ev->t.swap( ev->peek ); if(ev->t.id!=TID_EOF) ev->peek.scan(&ev->request.uri, ev->mode == ParserState::expand); if(ev->peek.id==TID_ERROR) return URL_FAIL_SYNTAX; }
+#define SCAN { ev->t.clear(); ev->t.swap( ev->peek ); if(ev->t.id!=TID_EOF) ev->peek.scan(&ev->request.uri, ev->mode == ParserState::expand, ev->end, ev->dictionary); if(ev->peek.id==TID_ERROR) return URL_FAIL_SYNTAX; }
 
     template<
             class TNode,
@@ -176,18 +293,26 @@ namespace Rest {
         /// \brief Parses a url and either adds or resolves within the expression tree
         /// The Url and parse mode are set in ParseData and determine if parse() returns when expression tree hits a dead-end
         /// or if it starts expanding the expression tree.
+        /// The parser is a single loop over the tokens of the Uri, it never recurses so stack use does not depend on
+        /// the length of the Uri or the number of arguments.
         ParseResult parse(ParserState* ev)
         {
-            ParseResult rv;
             long wid;
             Node* epc = context;
             LiteralType* lit;
             ArgumentType* arg;
 
+            // no need to go further if nothing below here handles the method
+            uint16_t method = (ev->mode == ParserState::resolve)
+                              ? Node::requestBit(ev->request.method)
+                              : (uint16_t)0xffff;
+
             // read datatype or decl type
             while(ev->t.id!=TID_EOF) {
                 rescan:
                 epc = context;
+                if((epc->reachable & method) == 0 && ev->mode == ParserState::resolve)
+                    return NoHandler;
 
                 switch(ev->state) {
                     case expectPathPartOrSep:
@@ -209,7 +334,7 @@ namespace Rest {
                     } break;
                     case expectHtmlSuffix: {
                         if(ev->t.is(TID_STRING , TID_IDENTIFIER)) {
-                            if(strcasecmp(ev->t.s, "html") !=0) {
+                            if(!ev->t.equals("html")) {
                                 return NoEndpoint;    // only supports no suffix, or html suffix
                             } else
                             NEXT_STATE(expectEof);  // always expect eof after suffix
@@ -231,8 +356,16 @@ namespace Rest {
                         else if(ev->t.is(TID_STRING, TID_IDENTIFIER)) {
                             // we must see if we already have a literal with this name
                             lit = nullptr;
-                            wid = pool->findLiteral(ev->t.s);
-                            if(wid>=0 && epc->literals) {
+                            if(ev->mode == ParserState::resolve && ev->t.len <= WORD_INLINE_SIZE) {
+                                // short words are compared inline without looking them up in the literals index
+                                lit = epc->literals;
+                                while(lit && lit->isValid() && !lit->matches(ev->t))
+                                    lit = lit->next;
+                                if(lit && !lit->matches(ev->t))
+                                    lit = nullptr;
+                            } else if((wid = ev->t.indexed
+                                    ? (long)ev->t.i
+                                    : pool->findLiteral(ev->t.s, ev->t.len)) >= 0 && epc->literals) {
                                 // word exists in dictionary, see if it is a literal of current endpoint
                                 lit = epc->literals;
                                 while(lit && lit->isValid() && lit->id!=wid)
@@ -255,14 +388,17 @@ namespace Rest {
                                         context = epc->wild;
 
                                         // add remaining URL as argument
-                                        ev->request.args.add( Argument(Type("_url", ARG_MASK_STRING), ev->t.original) );
+                                        ev->request.args.add( Type("_url", ARG_MASK_STRING), ev->t.original, ev->remaining(ev->t.original) );
 
                                         return UriMatchedWildcard;
                                     } else
                                         return NoEndpoint;
                                 }
-                            } else
+                            } else {
+                                if(ev->mode == ParserState::resolve && pool->countHits)
+                                    lit->hits.fetch_add(1, std::memory_order_relaxed);
                                 context = lit->nextNode;
+                            }
 
                             NEXT_STATE( expectPathSep );
 
@@ -278,7 +414,7 @@ namespace Rest {
                         // try to match a parameter by type
                         if(ev->t.is(TID_STRING, TID_IDENTIFIER) && epc->string!=nullptr) {
                             // we can match by string argument type (parameter match)
-                            ev->request.args.add( Argument(*epc->string, ev->t.s) );
+                            ev->request.args.add( *epc->string, ev->t.s, ev->t.len );
                             context = epc->string->nextNode;
                         } else if(ev->t.id==TID_INTEGER && epc->numeric!=nullptr) {
                             // numeric argument
@@ -292,8 +428,13 @@ namespace Rest {
                             // numeric argument
                             ev->request.args.add( Argument(*epc->boolean, ev->t.i>0) );
                             context = epc->boolean->nextNode;
+                        } else if(epc->wild != nullptr) {
+                            // no match by type, but we can still match the wildcard
+                            context = epc->wild;
+                            ev->request.args.add( Type("_url", ARG_MASK_STRING), ev->t.original, ev->remaining(ev->t.original) );
+                            return UriMatchedWildcard;
                         } else
-                        NEXT_STATE( errorExpectedIdentifierOrString ); // no match by type
+                            return NoEndpoint;  // no match by type
 
                         // successful match, jump to next endpoint node
                         NEXT_STATE( expectPathSep );
@@ -389,9 +530,9 @@ namespace Rest {
 
 
                             if(arg == nullptr) {
-                                // add the argument to the Endpoint
+                                // add the argument to the Endpoint, argument names are interned process wide
                                 assert( name.indexed );
-                                arg = pool->newArgumentType(name.i, typemask);
+                                arg = pool->newArgumentType(name.s, typemask);
                                 context = arg->nextNode = pool->newNode();
 
                                 if ((typemask & ARG_MASK_NUMBER) > 0) {
@@ -411,8 +552,10 @@ namespace Rest {
                                 }
                             }
 
-                            // mark that we encountered a new argument
+                            // mark that we encountered a new argument, and keep its name so the endpoint knows the
+                            // position of each of its arguments. The value is the typemask declared for the argument.
                             ev->nargs++;
+                            ev->request.args.add( Argument(*arg, (unsigned long)arg->typemask()) );
 #if 0 // going away
                             if(arg != nullptr) {
                                 if(ev->argtypes == nullptr)
@@ -422,13 +565,9 @@ namespace Rest {
                             }
 #endif
 
+                            // carry on with the rest of the expression from the argument's node, the same loop handles
+                            // every argument so parsing uses the same stack however many arguments the expression has
                             NEXT_STATE( expectPathSep );
-
-                            // recursively call parse so we can add more code at the end of this match
-                            if((rv=parse(ev))!=0)
-                                return rv;
-                            return UriMatched;   // inner recursive call would have completed call, so we are done too
-
                         }
                     } break;
 
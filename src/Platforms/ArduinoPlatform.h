@@ -93,10 +93,12 @@ namespace Rest {
                     case HTTP_PATCH: method = HttpPatch; break;
                     case HTTP_DELETE: method = HttpDelete; break;
                     case HTTP_OPTIONS: method = HttpOptions; break;
+                    case HTTP_HEAD: method = HttpHead; break;
                     default: return false;
                 }
 
-                return (bool)(req = endpoints.resolve(method, uri.c_str()));
+                // resolve straight from the String buffer, the length bounds the resolve so no terminated copy is needed
+                return (bool)(req = endpoints.resolve(method, uri.c_str(), uri.length()));
             }
 
             virtual bool handle(WebServerType &server, HTTPMethod requestMethod, String requestUri) {
@@ -165,8 +167,8 @@ namespace Rest {
             }
 
             virtual int defer(Endpoints &endpoints, TRequest &parent) {
-                String _uri_rest = parent["_url"];  // contains the remaining part of the URL
-                typename Endpoints::Request ep = endpoints.resolve(parent.method, _uri_rest.c_str());
+                const char* _uri_rest = parent["_url"];  // contains the remaining part of the URL
+                typename Endpoints::Request ep = endpoints.resolve(parent.method, _uri_rest);
                 if (ep) {
                     RequestType request(parent);
 #if 1
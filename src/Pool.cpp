@@ -16,7 +16,13 @@ namespace Rest {
         move._head = nullptr;
     }
 
+    PagedPool::~PagedPool()
+    {
+        release();
+    }
+
     PagedPool& PagedPool::operator=(PagedPool&& move) noexcept {
+        release();
         _page_size = move._page_size;
         _head = move._head;
         move._head = nullptr;
@@ -28,5 +34,32 @@ namespace Rest {
     {
     }
 
+    PagedPool::Page::~Page()
+    {
+        ::free(_data);
+    }
+
+    void PagedPool::release() {
+        while(_head) {
+            Page* p = _head;
+            _head = p->_next;
+            delete p;
+        }
+    }
+
+    void PagedPool::reset() {
+        if(_head == nullptr)
+            return;
+        if(_head->_next != nullptr) {
+            // combine into one page
+            size_t capacity = 0;
+            for(Page* p = _head; p != nullptr; p = p->_next)
+                capacity += p->_capacity;
+            release();
+            _head = new Page(capacity);
+        } else
+            _head->_insertp = 0;
+    }
+
 
 }
\ No newline at end of file
@@ -11,8 +11,8 @@
 
 
 namespace Rest {
-    // shared index of text strings
-    // assigned a unique integer ID to each word stored
+    // process wide index of argument names
+    // assigned a unique integer ID to each name stored, the words of endpoints are kept in a Rest::Dictionary
     extern binbag *literals_index;
 
     /// \brief dynamic memory allocator using memory pages
@@ -38,14 +38,26 @@ namespace Rest {
     public:
         explicit PagedPool(size_t page_size=64);
         PagedPool(PagedPool&& move) noexcept;
+        ~PagedPool();
 
         PagedPool& operator=(PagedPool&& move) noexcept;
 
+        /// \brief Allocate raw memory from the pool
+        /// The memory is aligned to align bytes, which must be a power of 2.
+        void* allocate(size_t sz, size_t align = sizeof(void*)) {
+            return alloc(sz, align);
+        }
+
+        /// \brief Release all objects in the pool at once but keep the memory for reuse
+        /// This lets a pool be used as an arena for short lived objects such as the arguments of a request. Object
+        /// destructors are not called. If the pool grew to more than one page, the pages are replaced by one page big
+        /// enough to hold them all so a pool that is reset after every request soon settles on a single page.
+        void reset();
+
 
         template<class T, typename ...Args>
         T* make(Args ... args) {
-            size_t sz = sizeof(T);
-            unsigned char* bytes = alloc(sz);
+            unsigned char* bytes = alloc(sizeof(T), alignof(T));
             return bytes
                 ? new (bytes) T(args...)
                 : nullptr;
@@ -53,8 +65,7 @@ namespace Rest {
 
         template<class T, typename ...Args>
         T* makeArray(size_t n, Args ... args) {
-            size_t sz = sizeof(T)*n;
-            T* first = (T*)alloc(sz);
+            T* first = (T*)alloc(sizeof(T)*n, alignof(T));
             if(first) {
                 T *p = first;
                 for (size_t i = 0; i < n; i++)
@@ -83,11 +94,14 @@ namespace Rest {
             Page(const Page& copy) = delete;
             Page& operator=(const Page& copy) = delete;
 
-            unsigned char* get(size_t sz) {
-                if(sz==0 || (_insertp+sz > _capacity))
+            ~Page();
+
+            unsigned char* get(size_t sz, size_t align=1) {
+                size_t at = (_insertp + align - 1) & ~(align - 1);
+                if(sz==0 || (at+sz > _capacity))
                     return nullptr;
-                unsigned char* out =  _data + _insertp;
-                _insertp += sz;
+                unsigned char* out =  _data + at;
+                _insertp = at + sz;
                 return out;
             }
 
@@ -97,12 +111,12 @@ namespace Rest {
             Page* _next;        // next page (unless we are the end)
         };
 
-        unsigned char* alloc(size_t sz) {
+        unsigned char* alloc(size_t sz, size_t align=1) {
             Page *p = _head, *lp = nullptr;
             unsigned char* out;
             if(sz==0) return nullptr;
             while(p) {
-                out = p->get(sz);
+                out = p->get(sz, align);
                 if(out != nullptr)
                     return out;
 
@@ -116,9 +130,11 @@ namespace Rest {
                 lp->_next = p;
             else
                 _head = p;  // first page
-            return p->get(sz);
+            return p->get(sz, align);
         }
 
+        void release();
+
     protected:
         size_t _page_size;
         Page *_head;        // first page in linked list of pages
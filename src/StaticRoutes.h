@@ -0,0 +1,209 @@
+//
+// Created by Colin MacKenzie on 2019-06-09.
+//
+
+#pragma once
+
+#include "Parser.h"
+
+#include <vector>
+#include <string>
+
+namespace Rest {
+
+    /// \brief A hash table of the endpoints that can be reached using only literals
+    /// Most requests are for endpoints with no arguments or wildcards, such as /api/system/status. The table maps the
+    /// whole path of each of these endpoints to its node so resolving one takes a single hash probe instead of a walk
+    /// of the node graph. Paths are case insensitive like literals and the handler is taken from the node at resolve
+    /// time. Endpoints are added to the table as handlers are attached to them, see Endpoints::handlersChanged().
+    template<class TNodeData>
+    class StaticRoutes {
+    public:
+        using NodeData = TNodeData;
+        using index_type = uint32_t;
+
+        static constexpr index_type npos = (index_type)-1;
+
+        /// \brief An endpoint and the offset of its path in the text block
+        struct Route {
+            uint32_t hash;
+            index_type text;
+            NodeData* node;
+        };
+
+    public:
+        StaticRoutes() : count(0), mask(0) {}
+
+        inline size_t size() const { return count; }
+
+        /// \brief Rebuild the table from the node graph starting at root, whose literals are words in dictionary
+        void build(NodeData* root, binbag* dictionary) {
+            clear();
+            if(root == nullptr)
+                return;
+            std::string path;
+            add(root, dictionary, path);
+            if(count == 0)
+                return;
+            rehash();
+            routes.shrink_to_fit();
+            text.shrink_to_fit();
+        }
+
+        /// \brief Add the endpoint at node, if it can be reached from root using only literals
+        /// Routes are only ever added, an endpoint whose handlers were all removed stays in the table but resolving
+        /// finds no handler there and searches the node graph instead.
+        void insert(NodeData* root, binbag* dictionary, NodeData* node) {
+            std::vector<const char*> words;
+            if(root == nullptr || node->methods == 0 || !pathTo(root, node, dictionary, words))
+                return;
+            std::string path;
+            for(auto w = words.rbegin(); w != words.rend(); w++) {
+                if(!path.empty())
+                    path += '/';
+                path += *w;
+            }
+            if(find(path.c_str()) != nullptr)
+                return;     // already in the table
+            append(path, node);
+            if(buckets.size() < 2*count)
+                rehash();
+            else
+                place(count - 1);
+        }
+
+        void clear() {
+            std::vector<Route>().swap(routes);
+            std::vector<index_type>().swap(buckets);
+            std::vector<char>().swap(text);
+            count = 0;
+            mask = 0;
+        }
+
+        /// \brief Find the node of the endpoint with the given path
+        /// The path may start and end with a single slash and ends at end (if given), a null or a query string. Returns
+        /// nullptr if the path is not in the table, the node graph must then be searched instead.
+        NodeData* find(const char* uri, const char* end = nullptr) const {
+            if(count == 0)
+                return nullptr;
+
+            auto at = [uri,end](const char* p) -> char {
+                char c = (end == nullptr || p < end) ? *p : 0;
+                return (c == '?') ? (char)0 : c;
+            };
+
+            // hash the path the same way it was added, skipping the leading and trailing slash
+            const char* begin = (at(uri) == '/') ? uri + 1 : uri;
+            const char* p = begin;
+            uint32_t hash = FNV32_OFFSET_BASIS;
+            char c;
+            while((c = at(p)) != 0) {
+                if(c == '/') {
+                    char next = at(p + 1);
+                    if(next == 0)
+                        break;          // trailing slash
+                    if(next == '/')
+                        return nullptr; // empty segment, leave to the node graph
+                }
+                hash = hash_nocase_step(hash, c);
+                p++;
+            }
+
+            size_t len = p - begin;
+            for(index_type b = hash & mask; buckets[b] != npos; b = (b+1) & mask) {
+                const Route& r = routes[buckets[b]];
+                const char* t = &text[r.text];
+                if(r.hash == hash && strncasecmp(t, begin, len) == 0 && t[len] == 0)
+                    return r.node;
+            }
+            return nullptr;
+        }
+
+    protected:
+        std::vector<Route> routes;
+        std::vector<index_type> buckets;
+        std::vector<char> text;
+        size_t count;
+        index_type mask;
+
+        /// \brief Add the endpoints of node and the nodes below it reached through literals
+        void add(NodeData* node, binbag* dictionary, std::string& path) {
+            if(node->methods != 0)
+                append(path, node);
+
+            size_t len = path.size();
+            for(auto lit = node->literals; lit != nullptr && lit->isValid(); lit = lit->next) {
+                if(lit->isNumeric || lit->nextNode == nullptr)
+                    continue;
+                const char* word = binbag_get(dictionary, lit->id);
+                if(!matchable(word))
+                    continue;
+                if(len > 0)
+                    path += '/';
+                path += word;
+                add(lit->nextNode, dictionary, path);
+                path.resize(len);
+            }
+        }
+
+        /// \brief Collect the words of the literals leading from at to node, last word first
+        /// Returns false if node is not below at or is reached through a word that does not match as a literal.
+        static bool pathTo(NodeData* at, NodeData* node, binbag* dictionary, std::vector<const char*>& words) {
+            if(at == node)
+                return true;
+            for(auto lit = at->literals; lit != nullptr && lit->isValid(); lit = lit->next) {
+                if(lit->isNumeric || lit->nextNode == nullptr)
+                    continue;
+                if(pathTo(lit->nextNode, node, dictionary, words)) {
+                    const char* word = binbag_get(dictionary, lit->id);
+                    if(!matchable(word))
+                        return false;
+                    words.push_back(word);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void append(const std::string& path, NodeData* node) {
+            Route r;
+            r.hash = hash_nocase(path.c_str());
+            r.text = (index_type)text.size();
+            r.node = node;
+            text.insert(text.end(), path.c_str(), path.c_str() + path.size() + 1);
+            routes.push_back(r);
+            count++;
+        }
+
+        /// \brief Size the buckets for the routes, keeping the load factor at or below 50%, and place every route
+        void rehash() {
+            size_t n = 2;
+            while(n < 2*count)
+                n <<= 1;
+            buckets.assign(n, npos);
+            mask = (index_type)(n - 1);
+            for(index_type i=0; i < (index_type)routes.size(); i++)
+                place(i);
+        }
+
+        inline void place(index_type i) {
+            index_type b = routes[i].hash & mask;
+            while(buckets[b] != npos)
+                b = (b+1) & mask;
+            buckets[b] = i;
+        }
+
+        /// \brief True if resolving would match the word as a literal
+        /// Words that scan as a number or boolean, such as 2 or true, never match a literal in the node graph so they
+        /// cannot be in the table either.
+        static bool matchable(const char* word) {
+            Token t;
+            const char* p = word;
+            t.scan(&p, false);
+            return t.is(TID_STRING, TID_IDENTIFIER) && *p == 0;
+        }
+    };
+
+    template<class TNodeData> constexpr typename StaticRoutes<TNodeData>::index_type StaticRoutes<TNodeData>::npos;
+
+}
@@ -7,6 +7,9 @@
 #include <string.h>
 #include <cstdlib>
 #include <stdio.h>
+#include <ctype.h>
+#include <utility>
+#include <algorithm>
 
 #include "Pool.h"
 
@@ -34,15 +37,54 @@
 #define typeof(x) __typeof__(x)
 #endif
 
+// FNV-1a parameters used to hash path segments
+#define FNV32_OFFSET_BASIS    2166136261u
+#define FNV32_PRIME           16777619u
+
+// path segments up to this many characters are also packed, lower cased, into a single 64 bit word
+#define WORD_INLINE_SIZE      8
+
 
 namespace Rest {
 
+/// \brief Add one character to a case insensitive FNV-1a hash
+inline uint32_t hash_nocase_step(uint32_t hash, char c) {
+  return (hash ^ (uint8_t)tolower((unsigned char)c)) * FNV32_PRIME;
+}
+
+/// \brief Case insensitive hash of a string
+/// Words that compare equal using strcasecmp() have the same hash. If end is null the string must be null terminated.
+inline uint32_t hash_nocase(const char* begin, const char* end = nullptr) {
+  uint32_t hash = FNV32_OFFSET_BASIS;
+  while((end == nullptr) ? *begin!=0 : begin < end)
+    hash = hash_nocase_step(hash, *begin++);
+  return hash;
+}
+
+/// \brief Add the character at offset k of a word to its packed lower case form
+/// Characters past WORD_INLINE_SIZE are ignored, so a packed word only identifies a word together with its length.
+inline uint64_t fold_word_step(uint64_t word, size_t k, char c) {
+  return (k < WORD_INLINE_SIZE)
+         ? word | ((uint64_t)(uint8_t)tolower((unsigned char)c) << (8*k))
+         : word;
+}
+
+/// \brief Pack the first WORD_INLINE_SIZE characters of a word lower cased into an integer
+/// Words of up to WORD_INLINE_SIZE characters that compare equal using strncasecmp() pack to the same integer.
+inline uint64_t fold_word(const char* s, size_t len) {
+  uint64_t word = 0;
+  for(size_t k=0; k < len && k < WORD_INLINE_SIZE; k++)
+    word = fold_word_step(word, k, s[k]);
+  return word;
+}
+
 class Token {
   public:
     typedef enum {
         allocString,
         indexAlways,
-        indexIfExists
+        indexIfExists,
+        viewString
     } index_option;
 
   public:
@@ -51,33 +93,60 @@ class Token {
     int64_t i;
     double d;
 
-    bool indexed;   // true if string was stored in binbag index, otherwise string was allocated
+    // length of the string in s
+    // Strings viewed from the input are not null terminated, always use the length when comparing them.
+    size_t len;
+
+    bool indexed;   // true if string was stored in binbag index
+    bool owned;     // true if string was allocated by the token and must be freed, otherwise it is a view of the index or the input
+
+    // case insensitive hash of string and identifier tokens, computed while scanning
+    uint32_t hash;
+
+    // first WORD_INLINE_SIZE characters of string and identifier tokens packed by fold_word(), computed while scanning
+    uint64_t word;
 
     // reference back to the original string
     const char* original;
 
-    inline Token() : id(0), s(nullptr), i(0), d(0), indexed(false), original(nullptr) {}
+    inline Token() : id(0), s(nullptr), i(0), d(0), len(0), indexed(false), owned(false), hash(0), word(0), original(nullptr) {}
 
     Token(const Token& copy)
-        : id(copy.id), s(nullptr), i(copy.i), d(copy.d), indexed(false), original(copy.original)
+        : id(copy.id), s(copy.s), i(copy.i), d(copy.d), len(copy.len), indexed(copy.indexed), owned(copy.owned),
+          hash(copy.hash), word(copy.word), original(copy.original)
     {
-      if(copy.s && copy.id >= 500) {
-        s = indexed
-            ? copy.s          // no need to allocate, copy was indexed in binbag
-            : strdup(copy.s);      }
+      if(owned)
+        s = dup(copy.s, copy.len);  // only allocated strings need a copy, indexed or viewed strings are shared
+    }
+
+    Token(Token&& move) noexcept : Token() {
+      swap(move);
+    }
+
+    Token& operator=(Token&& move) noexcept {
+      if(this != &move) {
+        clear();
+        swap(move);
+      }
+      return *this;
     }
 
     Token& operator=(const Token& copy) {
+      if(this == &copy)
+        return *this;
+      clear();
       id = copy.id;
+      s = copy.s;
       i = copy.i;
       d = copy.d;
+      len = copy.len;
       indexed = copy.indexed;
+      owned = copy.owned;
+      hash = copy.hash;
+      word = copy.word;
       original = copy.original;
-      if(copy.s && copy.id >= 500) {
-        s = indexed
-              ? copy.s          // no need to allocate, copy was indexed in binbag
-              : strdup(copy.s);
-      }
+      if(owned)
+        s = dup(copy.s, copy.len);
       return *this;
     }
 
@@ -85,16 +154,20 @@ class Token {
       clear();
     }
 
-    /// \brief clears the token and frees memory if token was a string
+    /// \brief clears the token and frees memory if token was an allocated string
     void clear()
     {
-      if (s && id >= 500 && !indexed)
+      if (s && owned)
         ::free((void*)s);
       id = 0;
       s = nullptr;
       i = 0;
       d = 0.0;
+      len = 0;
       indexed = false;
+      owned = false;
+      hash = 0;
+      word = 0;
       original = nullptr;
     }
 
@@ -102,61 +175,66 @@ class Token {
     /// If using a current and peek token during parsing, this can be more efficient than copying the token
     /// across by saving a possible string copy and memory allocation.
     void swap(Token& rhs) {
-      short _id = rhs.id;
-      const char *_s = rhs.s;
-      int64_t _i = rhs.i;
-      double _d = rhs.d;
-      bool _indexed = rhs.indexed;
-      const char* _original = rhs.original;
-      rhs.id = id;
-      rhs.s = s;
-      rhs.i = i;
-      rhs.d = d;
-      rhs.indexed = indexed;
-      rhs.original = original;
-      id = _id;
-      s = _s;
-      i = _i;
-      d = _d;
-      indexed = _indexed;
-      original = _original;
+      std::swap(id, rhs.id);
+      std::swap(s, rhs.s);
+      std::swap(i, rhs.i);
+      std::swap(d, rhs.d);
+      std::swap(len, rhs.len);
+      std::swap(indexed, rhs.indexed);
+      std::swap(owned, rhs.owned);
+      std::swap(hash, rhs.hash);
+      std::swap(word, rhs.word);
+      std::swap(original, rhs.original);
     }
 
-    void set(short _id, const char* _begin, const char* _end, index_option _index = allocString)
+    /// \brief set the token to a string value
+    /// With viewString the token only references the string range given, the range must outlive the token. This is
+    /// how tokens are scanned when resolving so the lexer never allocates. The other options copy the string into the
+    /// token or the dictionary, by default the process wide literals index.
+    void set(short _id, const char* _begin, const char* _end, index_option _index = allocString, binbag* dictionary = nullptr)
     {
+      if(dictionary == nullptr)
+        dictionary = literals_index;
       assert(_id >= 500);  // only IDs above 500 can store a string
       id = _id;
-      indexed = indexAlways;
+      indexed = false;
+      owned = false;
+      len = (_end == nullptr) ? strlen(_begin) : _end - _begin;
+
+      if(_index == viewString) {
+        s = _begin;
+        return;
+      }
 
       if(_index == indexIfExists) {
         // look in index and if word exists then use it
-        long idx = (_end == nullptr)
-                ? binbag_find(literals_index, _begin, strcasecmp)
-                : binbag_find_n(literals_index, _begin, _end - _begin, strncasecmp);
+        long idx = binbag_find_n(dictionary, _begin, len, strncasecmp);
         if(idx >=0) {
           indexed = true;
-          s = binbag_get(literals_index, i = idx);
+          s = binbag_get(dictionary, i = idx);
           return;
         }
       }
 
       if(_index == indexAlways) {
         // insert into the index
-        i = (_end == nullptr)
-                ? binbag_insert_distinct(literals_index, _begin, strcasecmp)
-                : binbag_insert_distinct_n(literals_index, _begin, _end - _begin, strncasecmp);
-        s = binbag_get(literals_index, i);
+        i = binbag_insert_distinct_n(dictionary, _begin, len, strncasecmp);
+        indexed = true;
+        s = binbag_get(dictionary, i);
       } else {
         // allocate memory and copy the string
-        if (_end == nullptr) {
-          s = strdup(_begin);
-        } else {
-          s = (char *) calloc(1, _end - _begin + 1);
-          memcpy((void*)s, _begin, _end - _begin);
-        }
+        owned = true;
+        s = dup(_begin, len);
       }
     }
 
+    /// \brief compare the string value of the token
+    inline bool equals(const char* str, bool case_insensitive = true) const {
+      return s != nullptr
+          && (case_insensitive ? strncasecmp(s, str, len) : strncmp(s, str, len)) == 0
+          && str[len] == 0;
+    }
+
     inline bool is(short _id) const {
       return id == _id;
     }
@@ -169,12 +247,9 @@ class Token {
     int isOneOf(std::initializer_list<const char*> enum_values, bool case_insensitive = true) {
       if (id <= 500)
         return -2;
-      typeof(strcmp) *cmpfunc = case_insensitive
-                                ? &strcasecmp
-                                : &strcmp;
       int j = 0;
       for (std::initializer_list<const char*>::const_iterator x = enum_values.begin(), _x = enum_values.end(); x != _x; x++, j++) {
-        if (cmpfunc(s, *x) == 0)
+        if (equals(*x, case_insensitive))
           return j;
       }
       return -1;
@@ -183,12 +258,9 @@ class Token {
     int toEnum(std::initializer_list<const char*> enum_values, bool case_insensitive = true) {
       if (id <= 500)
         return -2;
-      typeof(strcmp) *cmpfunc = case_insensitive
-                                ? &strcasecmp
-                                : &strcmp;
       int j = 0;
       for (std::initializer_list<const char*>::const_iterator x = enum_values.begin(), _x = enum_values.end(); x != _x; x++, j++) {
-        if (cmpfunc(s, *x) == 0) {
+        if (equals(*x, case_insensitive)) {
           clear();
           id = TID_INTEGER;
           i = j;
@@ -199,14 +271,22 @@ class Token {
     }
 
     /// \brief scans the next token from the URL line
-    int scan(const char** pinput, short allow_parameters)
+    /// If end is given the input does not have to be null terminated, scanning stops at end. When resolving
+    /// (allow_parameters is false) a '?' also ends the input so any query string is never matched against the endpoints.
+    /// Identifiers of an expression are indexed in the given dictionary, or the literals index if none is given.
+    int scan(const char** pinput, short allow_parameters, const char* end = nullptr, binbag* dictionary = nullptr)
     {
       const char* input = *pinput;
       char error[512];
 
+      // character at offset k from the input, or 0 if past the end of the input
+      auto at = [&input,end](size_t k) -> char {
+        return (end == nullptr || input + k < end) ? input[k] : 0;
+      };
+
       clear();
 
-      if (*input == 0) {
+      if (at(0) == 0 || (!allow_parameters && *input == '?')) {
         id = TID_EOF;
         *pinput = input;
         return 0;
@@ -217,7 +297,7 @@ class Token {
       // check for single character token
       // note: if we find a single char token we break and then return, otherwise (default) we jump over
       // to check for longer token types like keywords and attributes
-      if (strchr("/", *input) != nullptr) {
+      if (*input == '/') {
         s = nullptr;
         id = *input++;
         goto done;
@@ -233,13 +313,10 @@ class Token {
 
       // check for literal float
       if (input[0] == '.') {
-        if (isdigit(input[1])) {
+        if (isdigit(at(1))) {
           // decimal number
-          char *p;
-          id = TID_FLOAT;
-          d = strtod(input, &p);
+          id = scan_number(input, end, i, d);
           i = (int64_t) d;
-          input = p;
           goto done;
         } else {
           // plain dot symbol
@@ -248,35 +325,24 @@ class Token {
           input++;
           goto done;
         }
-      } else if (input[0] == '0' && input[1] == 'x') {
+      } else if (input[0] == '0' && at(1) == 'x') {
         // hex constant
-        char* p;
-        id = TID_INTEGER;
-        i = (int64_t)strtoll(input, &p, 16);
-        input = p;
+        id = scan_number(input, end, i, d, 16);
         goto done;
       } else if (isdigit(*input)) {
         //scan_number:
         // integer or float constant
-        char *p;
-        id = TID_INTEGER;
-        i = (int64_t)strtoll(input, &p, 0);
-        if (*p == '.') {
-          id = TID_FLOAT;
-          d = strtod(input, &p);
-          input = p;
-        } else
-          input = p;
+        id = scan_number(input, end, i, d);
         goto done;
       }
       // check for boolean value
-      else if (strncasecmp(input, "false", 5) == 0 && !isalnum(input[5])) {
+      else if (starts_word(input, end, "false")) {
         input += 5;
         id = TID_BOOL;
         i = 0;
         goto done;
       }
-      else if (strncasecmp(input, "true", 4) == 0 && !isalnum(input[4])) {
+      else if (starts_word(input, end, "true")) {
         input += 4;
         id = TID_BOOL;
         i = 1;
@@ -299,8 +365,11 @@ class Token {
       else {
         short ident = TID_IDENTIFIER;
         const char* p = input;
-        while( *input && *input!='/' ) {
-          if(!isalnum(*input) && *input != '_' && *input != '-' && *input != '.') {
+        uint32_t h = FNV32_OFFSET_BASIS;
+        uint64_t w = 0;
+        char c;
+        while( (c = at(0))!=0 && c!='/' && (allow_parameters || c!='?') ) {
+          if(!isalnum(c) && c != '_' && c != '-' && c != '.') {
             // encountered non-alpha character
             if(!allow_parameters) {
               // we can interpret as string since we arent limited to expression syntax
@@ -310,18 +379,21 @@ class Token {
               break;
             }
           }
+          h = hash_nocase_step(h, c);
+          w = fold_word_step(w, input - p, c);
           input++;
         }
 
         // success if we consumed 1 or more characters
         if(input > p) {
           set(ident, p, input,
-                  (ident != TID_IDENTIFIER)
-                      ? allocString                   // never use index on strings
-                      : allow_parameters
-                         ? indexAlways                // in expression mode so add identifiers to index
-                         : indexIfExists        // resolving URIs, so only use index if pre-existing identifier
+                  allow_parameters
+                     ? indexAlways                // in expression mode so add identifiers to index
+                     : viewString,                // resolving URIs, so just reference the input
+                  dictionary
           );
+          hash = h;
+          word = w;
           goto done;
         }
       }
@@ -335,6 +407,52 @@ done:
       *pinput = input;
       return 1;
     }
+
+  protected:
+    /// \brief Parse an integer or float constant from input that may not be null terminated
+    /// The number is copied into a small buffer first when end is given so strtoll and strtod cannot read past end.
+    /// An integer followed by a decimal point is re-parsed as a float, except for hex constants. Advances input past
+    /// the number and returns TID_INTEGER or TID_FLOAT.
+    static short scan_number(const char*& input, const char* end, int64_t& i, double& d, int base = 0) {
+      char buffer[64];
+      const char* begin = input;
+      if(end != nullptr) {
+        size_t n = std::min((size_t)(end - input), sizeof(buffer) - 1);
+        memcpy(buffer, input, n);
+        buffer[n] = 0;
+        begin = buffer;
+      }
+
+      char* p;
+      short _id = TID_INTEGER;
+      i = (int64_t)strtoll(begin, &p, base);
+      if (*p == '.' && base != 16) {
+        _id = TID_FLOAT;
+        d = strtod(begin, &p);
+      }
+      input += p - begin;
+      return _id;
+    }
+
+    /// \brief True if the input starts with the given lowercase word (case insensitive) and the word ends there
+    static bool starts_word(const char* input, const char* end, const char* word) {
+      size_t k = 0;
+      for(; word[k]; k++) {
+        if(end != nullptr && input + k >= end)
+          return false;
+        if(tolower((unsigned char)input[k]) != word[k])
+          return false;
+      }
+      return (end != nullptr && input + k >= end) || !isalnum(input[k]);
+    }
+
+    /// \brief allocate a null terminated copy of a string range
+    static char* dup(const char* str, size_t n) {
+      char* out = (char*)malloc(n + 1);
+      memcpy(out, str, n);
+      out[n] = 0;
+      return out;
+    }
 };
 
 
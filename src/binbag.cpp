@@ -23,6 +23,7 @@
 #undef inline
 #endif
 #include <algorithm>
+#include <ctype.h>
 
 #if defined(ARDUINO)
 #include <Arduino.h>
@@ -74,6 +75,8 @@ const uint32_t fencepost = 0xdefec8ed;
 #if defined(FENCEPOSTS) && FENCEPOSTS>0
 void check_fencepost(binbag* bb)
 {
+    if(bb->pages != NULL)
+        return;     // chunks have no fenceposts
     char s[512];
     uint32_t* fpmem = (uint32_t*)binbag_begin_iterator(bb) - FENCEPOSTS;
     for(int i=0; i<FENCEPOSTS; i++)
@@ -87,6 +90,8 @@ void check_fencepost(binbag* bb)
 
 void write_fencepost(binbag* bb)
 {
+    if(bb->pages != NULL)
+        return;
     uint32_t* fpmem = (uint32_t*)binbag_begin_iterator(bb) - FENCEPOSTS;
     for(int i=0; i<FENCEPOSTS; i++)
         fpmem[i] = fencepost;
@@ -114,7 +119,7 @@ void binbag_debug_print(binbag* bb)
             strcpy(s, "NULL!");
             offset = 0;
             slen = 0;
-        } else if(el < bb->begin || el > bb->tail) {
+        } else if(bb->pages == NULL && (el < bb->begin || el > bb->tail)) {
             sprintf(s, "out-of-bounds!   addr=0x%08llx", (unsigned long long) el);
             offset = 0;
             slen = 0;
@@ -135,6 +140,8 @@ void binbag_debug_print(binbag* bb)
 
     // print fenceposts
 #if defined(FENCEPOSTS) && FENCEPOSTS >0
+    if(bb->pages != NULL)
+        return;
     bool ok = true;
     default_binbag_print("fenceposts:");
     for(int j=0; j<FENCEPOSTS; j++) {
@@ -153,6 +160,329 @@ void binbag_debug_print(binbag* bb)
 void binbag_debug_print(binbag* bb) { printf("binbag: fencepost checking disabled.\n"); }
 #endif
 
+/* Chunked binbag routines
+ * A chunked binbag may be read by other threads while one thread inserts. Everything a reader can reach is written
+ * before it is published with a release store, the element count for elements and the slot ordinal for the hash
+ * index, and memory a reader may still be using, such as an outgrown hash index, is retired rather than freed.
+ */
+#define BB_LOAD(p)          __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define BB_STORE(p, v)      __atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+#define BB_PAGE_BASE    16      // element pointers in the first page, each page after holds twice as many
+#define BB_PAGES        32
+
+struct _binbag_chunk {
+    binbag_chunk *prev;
+    size_t size;
+    size_t used;        // bytes used, set once the chunk is full
+};
+
+static inline size_t binbag_page_of(size_t idx, size_t* offset)
+{
+    size_t q = idx / BB_PAGE_BASE + 1;
+    size_t k = sizeof(unsigned long)*8 - 1 - __builtin_clzl((unsigned long)q);
+    *offset = idx - BB_PAGE_BASE*(((size_t)1 << k) - 1);
+    return k;
+}
+
+/// \brief Returns where the pointer to the string at idx is kept
+static inline const char** binbag_element(binbag* bb, size_t idx)
+{
+    if(bb->pages == NULL)
+        return (const char**)(bb->end - sizeof(char*)) - idx;
+    size_t offset, k = binbag_page_of(idx, &offset);
+    return BB_LOAD(&bb->pages[k]) + offset;
+}
+
+static void binbag_retire(binbag* bb, void* mem)
+{
+    if(bb->pages == NULL || mem == NULL) {
+        free(mem);
+        return;
+    }
+    binbag_retired* r = (binbag_retired*)malloc(sizeof(binbag_retired));
+    if(r == NULL)
+        return;     // leak rather than free memory a reader may be using
+    r->mem = mem;
+    r->next = bb->retired;
+    bb->retired = r;
+}
+
+/* Hash index routines
+ * The index is an open addressing table of element ordinals with linear probing, kept at or below 50% load. Equal
+ * strings always start probing at the same slot and are added in ordinal order, so the first match found while probing
+ * is the lowest ordinal just like a linear scan would return. A table and its capacity are published together by a
+ * single store of the table pointer, a reader that misses probes again if the table was replaced meanwhile.
+ */
+static uint32_t binbag_hash(const char* s, size_t n, bool nocase)
+{
+    uint32_t h = 2166136261u;   // FNV-1a
+    for(size_t k=0; k<n && s[k]; k++)
+        h = (h ^ (uint8_t)(nocase ? tolower((unsigned char)s[k]) : s[k])) * 16777619u;
+    return h;
+}
+
+static inline bool binbag_index_nocase(binbag* bb)
+{
+    return (bb->index_flags & BB_INDEX_NOCASE) != 0;
+}
+
+static void binbag_index_put(binbag_slot* slots, size_t capacity, uint32_t hash, long idx)
+{
+    size_t mask = capacity - 1;
+    size_t b = hash & mask;
+    while(slots[b].idx != 0)
+        b = (b+1) & mask;
+    slots[b].hash = hash;
+    BB_STORE(&slots[b].idx, (uint32_t)idx + 1);
+}
+
+/// \brief Rehash the first n strings into a new table of the given capacity
+static bool binbag_index_rebuild(binbag* bb, size_t capacity, size_t n)
+{
+    binbag_index_table* table = (binbag_index_table*)calloc(1, sizeof(binbag_index_table) + capacity*sizeof(binbag_slot));
+    if(table == NULL)
+        return false;
+    table->capacity = capacity;
+    table->slots = (binbag_slot*)(table + 1);
+    bool nocase = binbag_index_nocase(bb);
+    for(size_t j=0; j<n; j++)
+        binbag_index_put(table->slots, capacity, binbag_hash(*binbag_element(bb, j), (size_t)-1, nocase), j);
+
+    binbag_index_table* old = bb->index;
+    BB_STORE(&bb->index, table);
+    binbag_retire(bb, old);
+    return true;
+}
+
+/// \brief Add the string at idx to the index, in a chunked binbag this is done before the string is published
+static void binbag_index_add(binbag* bb, long idx)
+{
+    if(2*(size_t)(idx+1) > bb->index->capacity) {
+        // rehash into a table twice the size, the new element is added by the rebuild
+        if(!binbag_index_rebuild(bb, 2*bb->index->capacity, idx+1))
+            binbag_index(bb, BB_INDEX_NONE);
+        return;
+    }
+    binbag_index_put(bb->index->slots, bb->index->capacity,
+            binbag_hash(*binbag_element(bb, idx), (size_t)-1, binbag_index_nocase(bb)), idx);
+}
+
+/// \brief Probe the index for hash, returns the first ordinal equal() accepts, -1 if none or -2 if there is no index
+/// Slots may refer to strings not yet published, equal() is only called for published strings.
+template<class Equal>
+static long binbag_index_probe(binbag* bb, uint32_t hash, Equal equal)
+{
+    const binbag_index_table* table;
+    long found;
+    do {
+        table = BB_LOAD(&bb->index);
+        if(table == NULL)
+            return -2;
+        const binbag_slot* slots = table->slots;
+        size_t mask = table->capacity - 1;
+        size_t count = binbag_count(bb);
+        found = -1;
+        uint32_t idx;
+        for(size_t b = hash & mask; (idx = BB_LOAD(&slots[b].idx)) != 0; b = (b+1) & mask) {
+            if(slots[b].hash == hash && idx <= count && equal((long)idx - 1)) {
+                found = (long)idx - 1;
+                break;
+            }
+        }
+    } while(found < 0 && BB_LOAD(&bb->index) != table);
+    return found;
+}
+
+/// \brief Find a string using the index, n is the length of match or (size_t)-1 if null terminated
+/// Returns -2 if the index cannot serve this lookup and the strings must be scanned instead.
+static long binbag_index_find(binbag* bb, const char* match, size_t n, bool nocase)
+{
+    if(BB_LOAD(&bb->index) == NULL || (nocase && !binbag_index_nocase(bb)))
+        return -2;
+    uint32_t hash = binbag_hash(match, n, binbag_index_nocase(bb));
+    return binbag_index_probe(bb, hash, [bb,match,n,nocase](long j) {
+        const char* el = binbag_get(bb, j);
+        return (n == (size_t)-1)
+                ? (nocase ? strcasecmp(el, match) : strcmp(el, match)) == 0
+                : (size_t)binbag_strlen(bb, j) == n && (nocase ? strncasecmp(el, match, n) : strncmp(el, match, n)) == 0;
+    });
+}
+
+/* Folded mode routines
+ * In BB_MODE_FOLDED a string is stored as its length, the string and a lower case copy. Case insensitive lookups fold
+ * the match once into a buffer on the stack, matches too long for the buffer are compared with strncasecmp() instead.
+ */
+#define BB_FOLD_BUFFER  128
+
+static inline uint32_t binbag_folded_length(const char* el)
+{
+    uint32_t len;
+    memcpy(&len, el - sizeof(uint32_t), sizeof(uint32_t));     // may be unaligned
+    return len;
+}
+
+/// \brief Lower case up to n characters of s into buf stopping at a null, returns the length or -1 if it did not fit
+/// The case insensitive hash of s is computed in the same pass.
+static long binbag_fold(char* buf, size_t size, const char* s, size_t n, uint32_t* hash = NULL)
+{
+    uint32_t h = 2166136261u;
+    size_t k=0;
+    for(; k<n && s[k]; k++) {
+        if(k+1 >= size)
+            return -1;
+        buf[k] = (char)tolower((uint8_t)s[k]);
+        h = (h ^ (uint8_t)buf[k]) * 16777619u;
+    }
+    buf[k] = 0;
+    if(hash != NULL)
+        *hash = h;
+    return (long)k;
+}
+
+static long binbag_find_folded(binbag *bb, const char* folded, size_t n, uint32_t hash)
+{
+    auto equal = [bb,folded,n](long j) {
+        const char* el = binbag_get(bb, j);
+        return binbag_folded_length(el) == n && memcmp(el + n + 1, folded, n) == 0;
+    };
+
+    if(BB_LOAD(&bb->index) != NULL && binbag_index_nocase(bb)) {
+        long idx = binbag_index_probe(bb, hash, equal);
+        if(idx != -2)
+            return idx;
+    }
+
+    for(long j=0, N=binbag_count(bb); j<N; j++) {
+        if(equal(j))
+            return j;
+    }
+    return -1;
+}
+
+/* Insertion routines
+ * binbag_insertn() copies a string while looking for its end when it can, the routines below are used when the length
+ * is needed up front, for folded strings and chunked binbags.
+ */
+
+/// \brief Make room for n bytes of string at the tail, returns false if the memory could not be allocated
+static bool binbag_reserve(binbag* bb, size_t n)
+{
+    if(bb->pages == NULL) {
+        if(binbag_free_space(bb) >= n + sizeof(char*))
+            return true;
+        size_t existing_capacity = bb->end - bb->begin;
+        size_t new_capacity = (size_t)(existing_capacity * std::min(10.0, std::max(1.1, bb->growth_rate))) + n + sizeof(char*);
+        return binbag_resize(bb, new_capacity) != 0;
+    }
+
+    if((size_t)(bb->end - bb->tail) >= n)
+        return true;
+
+    // start a new chunk, the strings in the old one stay where they are
+    size_t size = std::max(bb->chunk_size, n);
+    binbag_chunk* chunk = (binbag_chunk*)malloc(sizeof(binbag_chunk) + size);
+    if(chunk == NULL)
+        return false;
+    bb->chunks->used = bb->tail - bb->begin;
+    chunk->prev = bb->chunks;
+    chunk->size = size;
+    chunk->used = 0;
+    bb->chunks = chunk;
+    bb->begin = bb->tail = (char*)(chunk + 1);
+    bb->end = bb->begin + size;
+    bb->growths++;
+    return true;
+}
+
+/// \brief Add the string at el as the next element, the string ends before tail
+static long binbag_push(binbag* bb, const char* el, char* tail)
+{
+    size_t idx;
+    if(bb->pages == NULL) {
+        idx = binbag_count(bb);
+        *--bb->elements = el;
+        bb->tail = tail;
+        write_fencepost(bb);
+    } else {
+        idx = bb->count;
+        size_t offset, k = binbag_page_of(idx, &offset);
+        if(bb->pages[k] == NULL) {
+            const char** page = (const char**)malloc((BB_PAGE_BASE << k) * sizeof(char*));
+            if(page == NULL)
+                return -1;
+            BB_STORE(&bb->pages[k], page);
+        }
+        bb->pages[k][offset] = el;
+        bb->tail = tail;
+        if(bb->index != NULL)
+            binbag_index_add(bb, idx);
+        BB_STORE(&bb->count, idx + 1);      // publish, a reader that sees the count sees the string
+        return idx;
+    }
+    if(bb->index != NULL)
+        binbag_index_add(bb, idx);
+    return idx;
+}
+
+static long binbag_insertn_sized(binbag* bb, const char* str, int length)
+{
+    size_t n = 0;
+    while((length<0 || n<(size_t)length) && str[n])
+        n++;
+
+    if(bb->mode != BB_MODE_FOLDED) {
+        if(!binbag_reserve(bb, n + 1))
+            return -1;
+        char* el = bb->tail;
+        memcpy(el, str, n);
+        el[n] = 0;
+        return binbag_push(bb, el, el + n + 1);
+    }
+
+    if(!binbag_reserve(bb, sizeof(uint32_t) + 2*(n+1)))
+        return -1;
+    check_fencepost(bb);
+    uint32_t len = (uint32_t)n;
+    memcpy(bb->tail, &len, sizeof(uint32_t));
+    char* el = bb->tail + sizeof(uint32_t);
+    memcpy(el, str, n);
+    el[n] = 0;
+    binbag_fold(el + n + 1, n + 1, str, n);
+    return binbag_push(bb, el, el + 2*(n+1));
+}
+
+int binbag_mode(binbag* bb, int mode)
+{
+    if(bb->mode == mode)
+        return 1;
+    if(binbag_count(bb) > 0)
+        return 0;
+    bb->mode = mode;
+    return 1;
+}
+
+int binbag_index(binbag* bb, int flags)
+{
+    if(flags == BB_INDEX_NONE) {
+        binbag_index_table* old = bb->index;
+        BB_STORE(&bb->index, (binbag_index_table*)NULL);
+        binbag_retire(bb, old);
+        bb->index_flags = BB_INDEX_NONE;
+        return 1;
+    }
+
+    size_t capacity = 16;
+    while(capacity < 2*binbag_count(bb))
+        capacity <<= 1;
+    bb->index_flags = flags;
+    if(!binbag_index_rebuild(bb, capacity, binbag_count(bb))) {
+        binbag_index(bb, BB_INDEX_NONE);
+        return 0;
+    }
+    return 1;
+}
+
 binbag* binbag_create(size_t capacity_bytes, double growth_rate)
 {
     if(capacity_bytes<32)
@@ -174,6 +504,30 @@ binbag* binbag_create(size_t capacity_bytes, double growth_rate)
     return bb;
 }
 
+binbag* binbag_create_chunked(size_t chunk_bytes)
+{
+    if(chunk_bytes<32)
+        chunk_bytes = 32;
+    binbag* bb = (binbag*)calloc(1, sizeof(binbag));
+    if(bb== nullptr) return nullptr;
+    bb->chunks = (binbag_chunk*)malloc(sizeof(binbag_chunk) + chunk_bytes);
+    bb->pages = (const char***)calloc(BB_PAGES, sizeof(const char**));
+    if(bb->chunks==nullptr || bb->pages==nullptr) {
+        ::free(bb->chunks);
+        ::free(bb->pages);
+        ::free(bb);
+        return nullptr;
+    }
+    bb->chunks->prev = nullptr;
+    bb->chunks->size = chunk_bytes;
+    bb->chunks->used = 0;
+    bb->chunk_size = chunk_bytes;
+    bb->begin = bb->tail = (char*)(bb->chunks + 1);
+    bb->end = bb->begin + chunk_bytes;
+    bb->growth_rate = 1.0;
+    return bb;
+}
+
 binbag* binbag_split_string(int seperator, unsigned long flags, const char* str)
 {
     int slen=0, scnt = *str ? 1 : 0;
@@ -209,23 +563,51 @@ void binbag_free(binbag* bb)
 {
     // just a sanity check
     assert(bb->end > bb->begin);
-    free(bb->begin);
+    free(bb->index);
+    if(bb->pages == NULL)
+        free(bb->begin);
+    else {
+        for(binbag_chunk* chunk = bb->chunks, *prev; chunk != NULL; chunk = prev) {
+            prev = chunk->prev;
+            free(chunk);
+        }
+        for(int k=0; k<BB_PAGES; k++)
+            free((void*)bb->pages[k]);
+        free((void*)bb->pages);
+        for(binbag_retired* r = bb->retired, *next; r != NULL; r = next) {
+            next = r->next;
+            free(r->mem);
+            free(r);
+        }
+    }
     free(bb);
 }
 
 
 size_t binbag_byte_length(binbag* bb)
 {
-    return bb->tail - bb->begin;
+    size_t length = bb->tail - bb->begin;
+    if(bb->pages != NULL)
+        for(binbag_chunk* chunk = bb->chunks->prev; chunk != NULL; chunk = chunk->prev)
+            length += chunk->used;
+    return length;
 }
 
 size_t binbag_count(binbag* bb)
 {
+    if(bb->pages != NULL)
+        return BB_LOAD(&bb->count);
     return binbag_end_iterator(bb) - binbag_begin_iterator(bb);
 }
 
 size_t binbag_capacity(binbag* bb)
 {
+    if(bb->pages != NULL) {
+        size_t capacity = 0;
+        for(binbag_chunk* chunk = bb->chunks; chunk != NULL; chunk = chunk->prev)
+            capacity += chunk->size;
+        return capacity;
+    }
     return (char*)bb->elements - bb->begin - FENCEPOSTS*sizeof(fencepost);
 }
 
@@ -250,6 +632,9 @@ void __binbag_sanity_check(binbag* bb)
 
 size_t binbag_resize(binbag* bb, size_t capacity)
 {
+    if(bb->pages != NULL)
+        return binbag_capacity(bb);     // chunks grow as strings are inserted and never move
+
     size_t _text_memsize = bb->tail - bb->begin;    // amount of memory to store all existing strings (plus null term)
     char* old_bb_begin_ptr = bb->begin;       // keep mem location before realloc() which we need to recalculate index element pointers
     size_t _count = binbag_count(bb);   // number of string elements
@@ -282,6 +667,7 @@ size_t binbag_resize(binbag* bb, size_t capacity)
     }
 
     // realloc success, adjust other memory pointers
+    // (the hash index holds ordinals rather than pointers so it stays valid as is)
     bb->end = bb->begin + capacity;
     bb->tail = bb->begin + _text_memsize;
     bb->elements = binbag_end_iterator(bb) - _count;
@@ -331,12 +717,26 @@ size_t binbag_resize(binbag* bb, size_t capacity)
 
 size_t binbag_free_space(binbag* bb)
 {
+    if(bb->pages != NULL)
+        return bb->end - bb->tail;
     ssize_t free_space = (const char*)bb->elements - FENCEPOSTS* sizeof(fencepost) - bb->tail;
     return (free_space>0) ? (size_t)free_space : 0;
 }
 
 long binbag_insert_distinct(binbag* bb, const char* str, int (*compar)(const char*,const char*))
 {
+    long idx;
+    if(bb->mode == BB_MODE_FOLDED && compar == strcasecmp) {
+        idx = binbag_find(bb, str, compar);
+        return (idx >= 0) ? idx : binbag_insert(bb, str);
+    }
+    if(bb->index != NULL && (compar == strcmp || compar == strcasecmp)) {
+        idx = binbag_index_find(bb, str, (size_t)-1, compar == strcasecmp);
+        if(idx >= 0)
+            return idx;
+        if(idx == -1)
+            return binbag_insert(bb, str);
+    }
     for(size_t i=0, c=binbag_count(bb); i<c; i++)
         if(compar(binbag_get(bb, i), str) ==0)
             return i;
@@ -345,6 +745,18 @@ long binbag_insert_distinct(binbag* bb, const char* str, int (*compar)(const cha
 
 long  binbag_insert_distinct_n(binbag* bb, const char* str, size_t n, int (*compar)(const char*,const char*, size_t n))
 {
+    long idx;
+    if(bb->mode == BB_MODE_FOLDED && compar == strncasecmp) {
+        idx = binbag_find_n(bb, str, n, compar);
+        return (idx >= 0) ? idx : binbag_insertn(bb, str, n);
+    }
+    if(bb->index != NULL && (compar == strncmp || compar == strncasecmp)) {
+        idx = binbag_index_find(bb, str, n, compar == strncasecmp);
+        if(idx >= 0)
+            return idx;
+        if(idx == -1)
+            return binbag_insertn(bb, str, n);
+    }
     for(size_t i=0, c=binbag_count(bb); i<c; i++)
         if(binbag_strlen(bb, i)==n && compar(binbag_get(bb, i), str, n) ==0)
             return i;
@@ -358,6 +770,9 @@ long binbag_insert(binbag* bb, const char* str)
 
 long binbag_insertn(binbag *bb, const char *str, int length)
 {
+    if(bb->mode == BB_MODE_FOLDED || bb->pages != NULL)
+        return binbag_insertn_sized(bb, str, length);
+
     // trying to do this without needing a strlen() and a strcpy() operation
     bool all = false;
     int fs = (int)binbag_free_space(bb) - 5 - FENCEPOSTS* sizeof(fencepost); // save 4 bytes for added array element and the null character
@@ -389,17 +804,17 @@ long binbag_insertn(binbag *bb, const char *str, int length)
     }
 
     // accept the new string, add string pointer to elements, advance the tail insertion pointer
-    size_t idx = binbag_count(bb);      // our new string index
-    *--bb->elements = bb->tail;
-    bb->tail = _p+1;
-    write_fencepost(bb);
-    return idx;
+    return binbag_push(bb, bb->tail, _p+1);
 }
 
 //const unsigned char* binbag_binary_insert(const unsigned char* str, size_t len);
 
 const char* binbag_get(binbag* bb, long idx)
 {
+    if(bb->pages != NULL)
+        return (idx >= 0 && (size_t)idx < binbag_count(bb))
+            ? *binbag_element(bb, idx)
+            : NULL;
     const char** e = (const char**)(bb->end - sizeof(char*)) - idx;
     return (e >= binbag_begin_iterator(bb))
         ? *e
@@ -408,6 +823,15 @@ const char* binbag_get(binbag* bb, long idx)
 
 DS_EXPORT int binbag_strlen(binbag *bb, long idx)
 {
+    if(bb->mode == BB_MODE_FOLDED) {
+        const char* el = binbag_get(bb, idx);
+        return (el != NULL) ? (int)binbag_folded_length(el) : -1;
+    }
+    if(bb->pages != NULL) {
+        const char* el = binbag_get(bb, idx);     // strings in different chunks are not adjacent
+        return (el != NULL) ? (int)strlen(el) : -1;
+    }
+
     const char** i = (const char**)(bb->end - sizeof(char*)) - idx;     // ptr to indexed string
     const char** j = i - 1;                                             // ptr to next string after indexed string
     return (j >= binbag_begin_iterator(bb))                             // check if j points out of bounds
@@ -415,8 +839,37 @@ DS_EXPORT int binbag_strlen(binbag *bb, long idx)
         : bb->tail - *i - 1;                                            // j out-of-bounds, compute distance to string insertion ptr (binbag text tail)
 }
 
+const char* binbag_get_folded(binbag* bb, long idx)
+{
+    if(bb->mode != BB_MODE_FOLDED)
+        return NULL;
+    const char* el = binbag_get(bb, idx);
+    return (el != NULL) ? el + binbag_folded_length(el) + 1 : NULL;
+}
+
+long binbag_find_folded_n(binbag *bb, const char* folded, size_t n)
+{
+    if(bb->mode != BB_MODE_FOLDED)
+        return binbag_find_n(bb, folded, n, strncasecmp);
+    // the match is already lower case so hashing it as is gives the case insensitive hash
+    uint32_t hash = (BB_LOAD(&bb->index) != NULL) ? binbag_hash(folded, n, false) : 0;
+    return binbag_find_folded(bb, folded, n, hash);
+}
+
 long binbag_find(binbag *bb, const char* match, int (*compar)(const char*,const char*))
 {
+    if(bb->mode == BB_MODE_FOLDED && compar == strcasecmp) {
+        char folded[BB_FOLD_BUFFER];
+        uint32_t hash;
+        long len = binbag_fold(folded, sizeof(folded), match, (size_t)-1, &hash);
+        if(len >= 0)
+            return binbag_find_folded(bb, folded, len, hash);
+    }
+    if(BB_LOAD(&bb->index) != NULL && (compar == strcmp || compar == strcasecmp)) {
+        long idx = binbag_index_find(bb, match, (size_t)-1, compar == strcasecmp);
+        if(idx != -2)
+            return idx;
+    }
     for(long j=0, N=binbag_count(bb); j<N; j++) {
         const char *el = binbag_get(bb, j);
         if(compar(match, el) ==0) {
@@ -438,6 +891,18 @@ long binbag_find_nocase(binbag *bb, const char* match)
 
 long binbag_find_n(binbag *bb, const char* match, size_t n, int (*compar)(const char*,const char*, size_t n))
 {
+    if(bb->mode == BB_MODE_FOLDED && compar == strncasecmp) {
+        char folded[BB_FOLD_BUFFER];
+        uint32_t hash;
+        long len = binbag_fold(folded, sizeof(folded), match, n, &hash);
+        if(len >= 0)
+            return ((size_t)len == n) ? binbag_find_folded(bb, folded, n, hash) : -1;
+    }
+    if(BB_LOAD(&bb->index) != NULL && (compar == strncmp || compar == strncasecmp)) {
+        long idx = binbag_index_find(bb, match, n, compar == strncasecmp);
+        if(idx != -2)
+            return idx;
+    }
     for(long j=0, N=binbag_count(bb); j<N; j++) {
         const char *el = binbag_get(bb, j);
         if(binbag_strlen(bb, j)==n && compar(match, el, n) ==0) {
@@ -459,6 +924,14 @@ long binbag_find_nocase_n(binbag *bb, const char* match, size_t n)
 
 void binbag_inplace_reverse(binbag *bb)
 {
+    if(bb->pages != NULL) {
+        for(size_t i=0, N=binbag_count(bb); i+1 < N-i; i++)
+            std::swap(*binbag_element(bb, i), *binbag_element(bb, N-1-i));
+        if(bb->index != NULL && !binbag_index_rebuild(bb, bb->index->capacity, binbag_count(bb)))
+            binbag_index(bb, BB_INDEX_NONE);
+        return;
+    }
+
     // reverse string table in place
     char **begin = (char**)binbag_begin_iterator(bb),
          **end = (char**)binbag_end_iterator(bb)-1; // actually 'last'
@@ -468,6 +941,10 @@ void binbag_inplace_reverse(binbag *bb)
         *begin++ = *end;
         *end-- = w;
     }
+
+    // ordinals changed
+    if(bb->index != NULL && !binbag_index_rebuild(bb, bb->index->capacity, binbag_count(bb)))
+        binbag_index(bb, BB_INDEX_NONE);
 }
 
 int binbag_element_sort_desc (const void * _lhs, const void * _rhs)
@@ -493,6 +970,26 @@ binbag* binbag_sort(binbag *bb, int (*compar)(const void*,const void*))
     check_fencepost(bb);
     size_t N = binbag_count(bb);
 
+    if(bb->mode != BB_MODE_PLAIN || bb->pages != NULL) {
+        // sort a copy of the element pointers then insert the strings in that order so each gets its folded copy
+        binbag* sorted = binbag_create(binbag_byte_length(bb) + N*sizeof(char*), std::max(1.5, bb->growth_rate));
+        const char** order = (const char**)malloc((N+1)*sizeof(char*));
+        if(sorted == nullptr || order == nullptr) {
+            free(order);
+            if(sorted != nullptr)
+                binbag_free(sorted);
+            return nullptr;
+        }
+        binbag_mode(sorted, bb->mode);
+        for(size_t j=0; j<N; j++)
+            order[j] = binbag_get(bb, j);
+        qsort((void*)order, N, sizeof(char*), compar);
+        for(size_t j=N; j>0; j--)     // the element array grows down so the last pointer is ordinal 0
+            binbag_insert(sorted, order[j-1]);
+        free((void*)order);
+        return sorted;
+    }
+
     // create a new binbag with just enough capacity to hold a copy of bb (but sorted)
     size_t capacity = binbag_byte_length(bb) + N*sizeof(char*);
     binbag* sorted = binbag_create(capacity, bb->growth_rate);
@@ -577,12 +1074,235 @@ binbag* binbag_sort_distinct(binbag *bb, int (*compar)(const void*,const void*))
     return NULL;
 }
 
+static inline unsigned char binbag_fc_char(const char* s, size_t i, bool nocase)
+{
+    unsigned char c = (unsigned char)s[i];
+    return nocase ? (unsigned char)tolower(c) : c;
+}
+
+static unsigned char* binbag_fc_put_length(unsigned char* p, size_t n)
+{
+    while(n >= 0x80) {
+        *p++ = (unsigned char)(n | 0x80);
+        n >>= 7;
+    }
+    *p++ = (unsigned char)n;
+    return p;
+}
+
+static inline size_t binbag_fc_get_length(const unsigned char** p)
+{
+    size_t n = 0;
+    int shift = 0;
+    unsigned char c;
+    do {
+        c = *(*p)++;
+        n |= (size_t)(c & 0x7f) << shift;
+        shift += 7;
+    } while(c & 0x80);
+    return n;
+}
+
+struct binbag_fc_entry {
+    const char* s;
+    size_t n;
+    uint32_t ordinal;
+};
+
+// compares byte wise the same way binbag_fc_find() walks the blocks
+static int binbag_fc_compare(const binbag_fc_entry& lhs, const binbag_fc_entry& rhs, bool nocase)
+{
+    size_t n = (lhs.n < rhs.n) ? lhs.n : rhs.n;
+    for(size_t i=0; i < n; i++) {
+        unsigned char l = binbag_fc_char(lhs.s, i, nocase), r = binbag_fc_char(rhs.s, i, nocase);
+        if(l != r)
+            return (l < r) ? -1 : 1;
+    }
+    return (lhs.n == rhs.n) ? 0 : (lhs.n < rhs.n) ? -1 : 1;
+}
+
+binbag_fc* binbag_fc_create(binbag* bb, int block_size, int flags)
+{
+    bool nocase = (flags & BB_FC_NOCASE) != 0;
+    size_t N = binbag_count(bb);
+    if(block_size <= 0)
+        block_size = 16;
+
+    binbag_fc_entry* entries = (binbag_fc_entry*)malloc((N > 0 ? N : 1) * sizeof(binbag_fc_entry));
+    binbag_fc* fc = (binbag_fc*)calloc(1, sizeof(binbag_fc));
+    if(entries == NULL || fc == NULL) {
+        free(entries);
+        free(fc);
+        return NULL;
+    }
+    fc->block_size = block_size;
+    fc->flags = flags;
+
+    // worst case every string is stored whole with two lengths of up to 10 bytes
+    size_t bound = 0;
+    for(size_t i=0; i < N; i++) {
+        entries[i].s = binbag_get(bb, (long)i);
+        entries[i].n = (size_t)binbag_strlen(bb, (long)i);
+        entries[i].ordinal = (uint32_t)i;
+        bound += entries[i].n + 20;
+    }
+
+    // sorting by ordinal among equal strings keeps the lowest ordinal of duplicates
+    std::sort(entries, entries + N, [nocase](const binbag_fc_entry& lhs, const binbag_fc_entry& rhs) {
+        int c = binbag_fc_compare(lhs, rhs, nocase);
+        return (c != 0) ? c < 0 : lhs.ordinal < rhs.ordinal;
+    });
+    size_t count = 0;
+    for(size_t i=0; i < N; i++)
+        if(count == 0 || binbag_fc_compare(entries[count - 1], entries[i], nocase) != 0)
+            entries[count++] = entries[i];
+
+    size_t nblocks = (count + block_size - 1) / block_size;
+    fc->data = (unsigned char*)malloc(bound > 0 ? bound : 1);
+    fc->blocks = (uint32_t*)malloc((nblocks > 0 ? nblocks : 1) * sizeof(uint32_t));
+    fc->ordinals = (uint32_t*)malloc((count > 0 ? count : 1) * sizeof(uint32_t));
+    if(fc->data == NULL || fc->blocks == NULL || fc->ordinals == NULL) {
+        free(entries);
+        binbag_fc_free(fc);
+        return NULL;
+    }
+
+    unsigned char* p = fc->data;
+    for(size_t i=0; i < count; i++) {
+        const binbag_fc_entry& e = entries[i];
+        size_t prefix = 0;
+        if(i % block_size == 0) {
+            fc->blocks[i / block_size] = (uint32_t)(p - fc->data);
+        } else {
+            const binbag_fc_entry& prev = entries[i - 1];
+            while(prefix < e.n && prefix < prev.n
+                    && binbag_fc_char(e.s, prefix, nocase) == binbag_fc_char(prev.s, prefix, nocase))
+                prefix++;
+            p = binbag_fc_put_length(p, prefix);
+        }
+        p = binbag_fc_put_length(p, e.n - prefix);
+        for(size_t j=prefix; j < e.n; j++)
+            *p++ = binbag_fc_char(e.s, j, nocase);
+        fc->ordinals[i] = e.ordinal;
+        if(e.n > fc->max_length)
+            fc->max_length = e.n;
+    }
+    free(entries);
+
+    fc->count = count;
+    fc->nblocks = nblocks;
+    fc->data_size = (size_t)(p - fc->data);
+    unsigned char* shrunk = (unsigned char*)realloc(fc->data, fc->data_size > 0 ? fc->data_size : 1);
+    if(shrunk != NULL)
+        fc->data = shrunk;
+    return fc;
+}
+
+void binbag_fc_free(binbag_fc* fc)
+{
+    if(fc == NULL)
+        return;
+    free(fc->data);
+    free(fc->blocks);
+    free(fc->ordinals);
+    free(fc);
+}
+
+size_t binbag_fc_count(binbag_fc* fc)
+{
+    return fc->count;
+}
+
+size_t binbag_fc_byte_length(binbag_fc* fc)
+{
+    return fc->data_size + fc->nblocks * sizeof(uint32_t) + fc->count * sizeof(uint32_t);
+}
+
+long binbag_fc_find(binbag_fc* fc, const char* match, size_t n)
+{
+    bool nocase = (fc->flags & BB_FC_NOCASE) != 0;
+    if(n == (size_t)-1)
+        n = strlen(match);
+
+    // binary search for the last block whose first string is not greater than match
+    size_t lo = 0, hi = fc->nblocks;
+    while(lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        const unsigned char* p = fc->data + fc->blocks[mid];
+        size_t len = binbag_fc_get_length(&p);
+        size_t i = 0;
+        while(i < len && i < n && p[i] == binbag_fc_char(match, i, nocase))
+            i++;
+        bool greater = (i < len) && (i == n || p[i] > binbag_fc_char(match, i, nocase));
+        if(greater)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    if(lo == 0)
+        return -1;
+
+    // walk the block keeping m, the length of the prefix the previous string shares with match. A string sharing
+    // more than m with the previous one is still less than match, one sharing less is already greater.
+    size_t block = lo - 1;
+    size_t pos = block * fc->block_size;
+    size_t last = pos + fc->block_size;
+    if(last > fc->count)
+        last = fc->count;
+    const unsigned char* p = fc->data + fc->blocks[block];
+    size_t m = 0;
+    for(; pos < last; pos++) {
+        size_t prefix = (pos % fc->block_size == 0) ? 0 : binbag_fc_get_length(&p);
+        size_t len = binbag_fc_get_length(&p);
+        const unsigned char* suffix = p;
+        p += len;
+        if(prefix > m)
+            continue;
+        if(prefix < m)
+            return -1;
+
+        size_t k = 0;
+        while(k < len && m + k < n && suffix[k] == binbag_fc_char(match, m + k, nocase))
+            k++;
+        m += k;
+        if(k == len) {
+            if(m == n)
+                return (long)fc->ordinals[pos];
+        } else if(m == n || suffix[k] > binbag_fc_char(match, m, nocase))
+            return -1;
+    }
+    return -1;
+}
+
+long binbag_fc_get(binbag_fc* fc, long pos, char* buf, size_t size)
+{
+    if(pos < 0 || (size_t)pos >= fc->count)
+        return -1;
+
+    // rebuild the strings of the block up to pos, each one reuses the prefix left in buf by the one before it
+    size_t first = (size_t)pos / fc->block_size * fc->block_size;
+    const unsigned char* p = fc->data + fc->blocks[(size_t)pos / fc->block_size];
+    size_t length = 0;
+    for(size_t i = first; i <= (size_t)pos; i++) {
+        size_t prefix = (i == first) ? 0 : binbag_fc_get_length(&p);
+        size_t len = binbag_fc_get_length(&p);
+        for(size_t j=0; j < len; j++)
+            if(prefix + j + 1 < size)
+                buf[prefix + j] = (char)p[j];
+        p += len;
+        length = prefix + len;
+    }
+    if(size > 0)
+        buf[(length < size) ? length : size - 1] = 0;
+    return (long)length;
+}
+
 const char **binbag_begin_iterator(binbag *bb) {
-	return bb->elements;
+	return (bb->pages == NULL) ? bb->elements : NULL;
 }
 
 const char **binbag_end_iterator(binbag *bb) {
-	return (const char **)bb->end;
+	return (bb->pages == NULL) ? (const char **)bb->end : NULL;
 }
 
 //const unsigned char* binbag_binary_get(binbag* bb, size_t idx, size_t* len_out);
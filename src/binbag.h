@@ -15,6 +15,39 @@ extern "C" {
 #define SF_NONE             0
 #define SF_IGNORE_EMPTY     1
 
+// hash index flags
+#define BB_INDEX_NONE       0
+#define BB_INDEX_CASE       1       // index for case sensitive lookups
+#define BB_INDEX_NOCASE     2       // index for case insensitive lookups, also serves case sensitive lookups
+
+// storage modes
+#define BB_MODE_PLAIN       0       // strings are stored as is
+#define BB_MODE_FOLDED      1       // strings are stored with their length and a lower case copy, see binbag_mode()
+
+// front coded binbag flags
+#define BB_FC_CASE          0       // strings are sorted and found case sensitive
+#define BB_FC_NOCASE        1       // strings are stored lower case, sorted and found case insensitive
+
+/// \brief A slot of the hash index, idx is the element ordinal plus one or zero if the slot is empty
+typedef struct _binbag_slot {
+    uint32_t hash;
+    uint32_t idx;
+} binbag_slot;
+
+/// \brief The hash index, the capacity is kept with the slots so readers always probe with the size of the table they loaded
+typedef struct _binbag_index_table {
+    size_t capacity;            // number of slots, always a power of 2
+    binbag_slot *slots;         // follows the table in the same allocation
+} binbag_index_table;
+
+/// \brief A block of string memory of a chunked binbag, see binbag_create_chunked()
+typedef struct _binbag_chunk binbag_chunk;
+
+/// \brief Memory that readers of a chunked binbag may still be using, freed along with the binbag
+typedef struct _binbag_retired {
+    struct _binbag_retired *next;
+    void *mem;
+} binbag_retired;
 
 
 typedef struct _binbag {
@@ -39,11 +72,56 @@ typedef struct _binbag {
 
     // the number of growths we did
     size_t growths;
+
+    // optional open addressing hash index of the strings, see binbag_index()
+    // The index refers to strings by ordinal so it is not affected when the buffer is moved by binbag_resize().
+    binbag_index_table *index;
+    int index_flags;
+
+    // how strings are stored, in BB_MODE_FOLDED each string is laid out as [uint32 length][string\0][lower case\0]
+    // and the element points at the string so binbag_get() works the same in either mode.
+    int mode;
+
+    // chunked binbags only, see binbag_create_chunked()
+    // Strings are written into a list of chunks that are never moved, begin, end and tail then describe the newest
+    // chunk and elements is unused. Element pointers are kept in pages, page k holds 16<<k pointers, and count is
+    // written last when inserting so a reader that sees the count also sees the string. A binbag is chunked if it
+    // has pages, since unlike chunks the directory of pages never changes.
+    binbag_chunk *chunks;
+    const char ***pages;
+    size_t count;
+    size_t chunk_size;
+    binbag_retired *retired;
 } binbag;
 
+/// \brief A sorted, read only and front coded copy of a binbag, see binbag_fc_create()
+/// The strings are stored in blocks. The first string of a block is stored whole, every other string as the length of
+/// the prefix it shares with the string before it followed by the rest of the string. Lengths are varints so most take
+/// a single byte. The offsets of the blocks are a sparse index that is binary searched by the first string of each block.
+typedef struct _binbag_fc {
+    unsigned char *data;
+    size_t data_size;
+    uint32_t *blocks;           // offset of each block in data
+    size_t nblocks;
+    uint32_t *ordinals;         // ordinal of each string in the binbag it was created from, in sorted order
+    size_t count;
+    size_t max_length;          // length of the longest string
+    int block_size;
+    int flags;
+} binbag_fc;
+
 /// \brief Allocate a new empty binbag
 DS_EXPORT binbag *binbag_create(size_t capacity_bytes, double growth_rate);
 
+/// \brief Allocate a new empty binbag that never moves its strings
+/// Rather than growing one buffer the strings are stored in chunks of chunk_bytes (or larger for a long string), so
+/// pointers returned by binbag_get() stay valid until the binbag is freed and binbag_resize() does nothing. One thread
+/// may insert while other threads call binbag_count(), binbag_get(), binbag_get_folded(), binbag_strlen() and the
+/// binbag_find functions without locking, new strings are published with release semantics. Changing the mode or
+/// index, reversing or freeing the binbag still requires that no other thread is using it. The strings are not
+/// contiguous so binbag_begin_iterator() and binbag_end_iterator() return NULL.
+DS_EXPORT binbag *binbag_create_chunked(size_t chunk_bytes);
+
 DS_EXPORT binbag* binbag_split_string(int seperator, unsigned long flags, const char* str);
 
 //binbag* binbag_create_from_array(const char** arr, size_t count, double fill_space, double growth_rate);
@@ -52,6 +130,20 @@ DS_EXPORT void binbag_free(binbag *bb);
 
 DS_EXPORT size_t binbag_resize(binbag *bb, size_t capacity);
 
+/// \brief Keep a hash index of the strings so finding a string takes constant time
+/// With an index binbag_find(), binbag_find_n(), binbag_insert_distinct() and binbag_insert_distinct_n() no longer
+/// scan every string when the comparison is strcmp, strcasecmp, strncmp or strncasecmp (or the _case and _nocase
+/// variants). A BB_INDEX_CASE index only serves case sensitive lookups, BB_INDEX_NOCASE serves both. The index is
+/// kept up to date as strings are inserted, BB_INDEX_NONE drops it. Returns 0 if the index could not be allocated.
+DS_EXPORT int binbag_index(binbag *bb, int flags);
+
+/// \brief Set how strings are stored, only an empty binbag can change mode
+/// In BB_MODE_FOLDED every string is stored with its length and a lower case copy. binbag_strlen() then reads the
+/// length instead of computing it and case insensitive lookups compare the length and then memcmp() the lower case
+/// copy against the match folded once, rather than folding both strings character by character. Costs 4 bytes plus
+/// the length of the string again for every string. Returns 0 if the binbag is not empty.
+DS_EXPORT int binbag_mode(binbag *bb, int mode);
+
 /// \brief Returns the bytes used for all the strings combined
 DS_EXPORT size_t binbag_byte_length(binbag *bb);
 
@@ -81,6 +173,9 @@ DS_EXPORT const char *binbag_get(binbag *bb, long idx);
 // get the length of the string at the given index
 DS_EXPORT int binbag_strlen(binbag *bb, long idx);
 
+/// \brief Returns the lower case copy of the string at the given index, or NULL if the binbag is not BB_MODE_FOLDED
+DS_EXPORT const char *binbag_get_folded(binbag *bb, long idx);
+
 //const unsigned char* binbag_binary_get(int idx, size_t* len_out);
 
 /// \brief Find the ordinal index of the given string using the supplied comparison function (works with strcmp, strcasecmp, etc)
@@ -98,6 +193,11 @@ DS_EXPORT long binbag_find_case_n(binbag *bb, const char* match, size_t n);
 /// \brief Find the ordinal index of the given string using a case insensitive comparison with length
 DS_EXPORT long binbag_find_nocase_n(binbag *bb, const char* match, size_t n);
 
+/// \brief Find the ordinal index of a string that is already lower case, with length
+/// The match is compared without case folding, so in BB_MODE_FOLDED this is a length check and a memcmp() per
+/// candidate. In other modes it is the same as binbag_find_nocase_n().
+DS_EXPORT long binbag_find_folded_n(binbag *bb, const char* folded, size_t n);
+
 /// \brief Find the ordinal index of the given string using the supplied comparison function with length (works with strcmp, strcasecmp, etc)
 long binbag_find_n(binbag *bb, const char* match, size_t n, int (*compar)(const char*,const char*, size_t n));
 
@@ -127,6 +227,30 @@ DS_EXPORT binbag* binbag_sort_distinct(binbag *bb, int (*compar)(const void*,con
 
 DS_EXPORT void binbag_debug_print(binbag* bb);
 
+/// \brief Create a sorted, front coded copy of the strings of bb
+/// Dictionaries of words sharing long prefixes, such as sensor-00 to sensor-99, take much less memory this way while a
+/// string is still found in O(log n). Strings are grouped block_size to a block (16 if 0), a larger block saves more
+/// memory but scans further. With BB_FC_NOCASE strings that differ only in case are stored once. Duplicates keep the
+/// lowest ordinal, the same one binbag_find() returns. Returns NULL if memory could not be allocated.
+DS_EXPORT binbag_fc* binbag_fc_create(binbag* bb, int block_size, int flags);
+
+DS_EXPORT void binbag_fc_free(binbag_fc* fc);
+
+/// \brief Returns the number of distinct strings
+DS_EXPORT size_t binbag_fc_count(binbag_fc* fc);
+
+/// \brief Returns the bytes used by the strings and the index combined
+DS_EXPORT size_t binbag_fc_byte_length(binbag_fc* fc);
+
+/// \brief Find a string, n is the length of match or (size_t)-1 if it is null terminated
+/// Returns the ordinal the string had in the binbag the front coded copy was created from, or -1 if not found.
+DS_EXPORT long binbag_fc_find(binbag_fc* fc, const char* match, size_t n);
+
+/// \brief Copy the string at sorted position pos into buf
+/// Returns the length of the string, or -1 if pos is out of bounds. At most size-1 characters and a null are copied,
+/// a buffer of max_length+1 always holds the whole string.
+DS_EXPORT long binbag_fc_get(binbag_fc* fc, long pos, char* buf, size_t size);
+
 DS_EXPORT const char **binbag_begin_iterator(binbag *bb);
 
 DS_EXPORT const char **binbag_end_iterator(binbag *bb);
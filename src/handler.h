@@ -8,6 +8,15 @@
 #include <functional>
 #include <memory>
 #include <tuple>
+#include <new>
+#include <type_traits>
+#include <cstring>
+
+// bytes of storage for the callable in an InlineHandler, enough for a function pointer or a lambda capturing two
+// pointers. Binding an object to a member function pointer, as with(object) does, needs 3*sizeof(void*).
+#if !defined(RESTFULLY_HANDLER_STORAGE)
+#define RESTFULLY_HANDLER_STORAGE    (2*sizeof(void*))
+#endif
 
 
 namespace Rest {
@@ -22,6 +31,9 @@ namespace Rest {
         HttpPatch,
         HttpDelete,
         HttpOptions,
+        HttpHead,
+        HttpCustom,         // application defined verbs are (HttpMethod)(HttpCustom+n) up to HttpMethodMax
+        HttpMethodMax = 15
     } HttpMethod;
 
 /// \brief Convert a http method enum value to a string.
@@ -55,6 +67,56 @@ namespace Rest {
         F0 handler;
     };
 
+    /// \brief A handler that stores its callable inline rather than in a std::function
+    /// Function pointers and small lambdas are kept in a fixed size buffer in the handler, so attaching or copying a
+    /// handler never allocates and the handler is smaller than a std::function. The callable must fit in
+    /// RESTFULLY_HANDLER_STORAGE bytes and be trivially copyable, i.e. capture pointers and values but not
+    /// std::string or std::function. Invoking is a single indirect call.
+    template<class... TArgs>
+    class InlineHandler {
+    public:
+        typedef int (*Invoker)(const void* callable, TArgs... args);
+
+        static constexpr std::size_t capacity = RESTFULLY_HANDLER_STORAGE;
+
+        inline InlineHandler() : invoker(nullptr) {}
+        inline InlineHandler(std::nullptr_t) : invoker(nullptr) {}
+
+        template<class F, class = typename std::enable_if< !std::is_same<F, InlineHandler>::value >::type>
+        InlineHandler(F f) : invoker(&invoke<F>) {
+            static_assert(sizeof(F) <= capacity, "callable is too large for InlineHandler, increase RESTFULLY_HANDLER_STORAGE");
+            static_assert(alignof(F) <= alignof(void*), "callable is over aligned for InlineHandler");
+            static_assert(std::is_trivially_copy_constructible<F>::value && std::is_trivially_destructible<F>::value,
+                    "InlineHandler can only store trivially copyable callables");
+            memset(storage, 0, capacity);   // unused bytes are cleared so same() can compare the whole buffer
+            new(storage) F(f);
+        }
+
+        inline int operator()(TArgs... args) const {
+            return invoker(storage, args...);
+        }
+
+        inline bool operator==(std::nullptr_t) const { return invoker==nullptr; }
+        inline bool operator!=(std::nullptr_t) const { return invoker!=nullptr; }
+        inline explicit operator bool() const { return invoker!=nullptr; }
+
+        /// \brief True if both handlers hold the same type of callable with the same captures
+        inline bool same(const InlineHandler& other) const {
+            return invoker == other.invoker && (invoker == nullptr || memcmp(storage, other.storage, capacity) == 0);
+        }
+
+    protected:
+        Invoker invoker;
+        alignas(void*) unsigned char storage[capacity];
+
+        template<class F>
+        static int invoke(const void* callable, TArgs... args) {
+            return (*(F*)const_cast<void*>(callable))(args...);
+        }
+    };
+
+    template<class... TArgs> constexpr std::size_t InlineHandler<TArgs...>::capacity;
+
 #if 0
     /*** Function Traits
      *  adapted from boost::function_traits
@@ -323,6 +385,89 @@ struct function_traits<std::_Binder<std::_Unforced, ReturnTypeT(__cdecl &)(Args
     {};
 
 #endif
+
+    // defined in Argument.h
+    template<class T> struct ArgumentValue;
+
+    // defined in Parser.h
+    template<class TRequest> std::size_t typed_arguments_begin(const TRequest& request, std::size_t arity);
+
+    /// \brief A compile time list of indices, used to expand the arguments of a typed handler
+    template<std::size_t... I>
+    struct index_sequence {};
+
+    template<std::size_t N, std::size_t... I>
+    struct make_index_sequence : make_index_sequence<N-1, N-1, I...> {};
+
+    template<std::size_t... I>
+    struct make_index_sequence<0, I...> : index_sequence<I...> {};
+
+    /// \brief Number of parameters an Endpoints handler type is invoked with
+    template<typename THandler>
+    struct handler_arity : std::integral_constant<std::size_t, function_traits<THandler>::arity> {};
+
+    template<class... TArgs>
+    struct handler_arity< Handler<TArgs...> > : std::integral_constant<std::size_t, sizeof...(TArgs)> {};
+
+    template<class... TArgs>
+    struct handler_arity< InlineHandler<TArgs...> > : std::integral_constant<std::size_t, sizeof...(TArgs)> {};
+
+    /// \brief Adapts a typed handler to a handler that only takes the request
+    /// A typed handler has a parameter for each argument of the endpoint, i.e. int(Request&, long id, long n) for
+    /// the endpoint "dev/:id(integer)/ch/:n(integer)". When invoked the arguments of the request are decoded by position
+    /// straight into the parameters, the request must have the args and status members of UriRequest.
+    template<class R, class TRequest, class... TArgs>
+    class TypedHandler {
+    public:
+        typedef R(*F)(TRequest&, TArgs...);
+
+        /// number of Uri arguments the handler receives
+        static constexpr std::size_t arity = sizeof...(TArgs);
+
+        explicit TypedHandler(F _f) : f(_f) {}
+
+        inline R operator()(TRequest& request) const {
+            return invoke(request, make_index_sequence<arity>());
+        }
+
+        F f;
+
+    protected:
+        template<std::size_t... I>
+        inline R invoke(TRequest& request, index_sequence<I...>) const {
+            std::size_t begin = typed_arguments_begin(request, arity);
+            return f(request, ArgumentValue<TArgs>::get(request.args[(int)(begin + I)])...);
+        }
+    };
+
+    /// \brief True if two handlers are known to invoke the same function
+    /// Function pointers and member function pointers compare by value, Handler only if both wrap the same plain
+    /// function. Handlers that cannot be compared, such as a std::function holding a lambda, are never the same.
+    template<class THandler>
+    inline bool same_handler(const THandler& a, const THandler& b, std::true_type) { return a == b; }
+
+    template<class THandler>
+    inline bool same_handler(const THandler&, const THandler&, std::false_type) { return false; }
+
+    template<class THandler>
+    inline bool same_handler(const THandler& a, const THandler& b) {
+        return same_handler(a, b, std::integral_constant<bool,
+                std::is_pointer<THandler>::value || std::is_member_pointer<THandler>::value>());
+    }
+
+    template<class... TArgs>
+    inline bool same_handler(const Handler<TArgs...>& a, const Handler<TArgs...>& b) {
+        typedef int (*F)(TArgs...);
+        const F* fa = a.handler.template target<F>();
+        const F* fb = b.handler.template target<F>();
+        return fa != nullptr && fb != nullptr && *fa == *fb;
+    }
+
+    template<class... TArgs>
+    inline bool same_handler(const InlineHandler<TArgs...>& a, const InlineHandler<TArgs...>& b) {
+        return a.same(b);
+    }
+
 } // ns: Rest
 
 #endif //RESTFULLY_FUNCTION_TRAITS_H
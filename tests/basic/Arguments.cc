@@ -39,7 +39,7 @@ TEST(arguments_constructor_copy_range) {
             A("y", ARG_MASK_INTEGER, 6l)
     };
     Arguments args(_args, 2);
-    return (args.count()==2) && (args.capacity()==2)
+    return (args.count()==2) && (args.capacity()==Arguments::inline_capacity)
             && (strcmp(args[0].name(), "x")==0) && args[0].l==2l
             && (strcmp(args[1].name(), "y")==0) && args[1].l==6l
         ? OK
@@ -66,7 +66,7 @@ TEST(arguments_constructor_copy_constructor) {
     };
     Arguments args_first(_args, 2);
     Arguments args(args_first);
-    return (args.count()==2) && (args.capacity()==2)
+    return (args.count()==2) && (args.capacity()==Arguments::inline_capacity)
            && (strcmp(args[0].name(), "x")==0) && args[0].l==2l
            && (strcmp(args[1].name(), "y")==0) && args[1].l==6l
        ? OK
@@ -81,7 +81,7 @@ TEST(arguments_constructor_copy_assignment) {
     Arguments args_first(_args, 2);
     Arguments args;
     args = args_first;
-    return (args.count()==2) && (args.capacity()==2)
+    return (args.count()==2) && (args.capacity()==Arguments::inline_capacity)
            && (strcmp(args[0].name(), "x")==0) && args[0].l==2l
            && (strcmp(args[1].name(), "y")==0) && args[1].l==6l
        ? OK
@@ -99,7 +99,7 @@ TEST(arguments_plus_operator) {
     Arguments args1(_args1, 2);
     Arguments args2(_args2, 1);
     Arguments args = args1 + args2;
-    return (args.count()==3) && (args.capacity()==3)
+    return (args.count()==3) && (args.capacity()==Arguments::inline_capacity)
            && (strcmp(args[0].name(), "x")==0) && args[0].l==2l
            && (strcmp(args[1].name(), "y")==0) && args[1].l==6l
            && (strcmp(args[2].name(), "z")==0) && args[2].l==4l
@@ -111,7 +111,7 @@ TEST(arguments_add_types) {
     Arguments args;
     args.add( Type("x", ARG_MASK_INTEGER) );
     args.add( Type("y", ARG_MASK_INTEGER) );
-    return (args.count()==2) && (args.capacity()==2)
+    return (args.count()==2) && (args.capacity()==Arguments::inline_capacity)
            && (strcmp(args[0].name(), "x")==0)
            && (strcmp(args[1].name(), "y")==0)
        ? OK
@@ -122,7 +122,7 @@ TEST(arguments_add_arguments) {
     Arguments args;
     args.add( A("x", ARG_MASK_INTEGER, 4l) );
     args.add( A("y", ARG_MASK_INTEGER, 6l) );
-    return (args.count()==2) && (args.capacity()==2)
+    return (args.count()==2) && (args.capacity()==Arguments::inline_capacity)
            && (strcmp(args[0].name(), "x")==0) && args[0].l==4l
            && (strcmp(args[1].name(), "y")==0) && args[1].l==6l
            ? OK
@@ -135,10 +135,84 @@ TEST(arguments_constructor_operator_idx) {
             A("y", ARG_MASK_INTEGER, 6l)
     };
     Arguments args(_args, 2);
-    return (args.count()==2) && (args.capacity()==2)
+    return (args.count()==2) && (args.capacity()==Arguments::inline_capacity)
            && args["y"].l==6l
            && args["x"].l==2l
            ? OK
            : FAIL;
 }
 
+
+TEST(arguments_arena) {
+    PagedPool arena(128);
+    Arguments args(arena);
+    args.add( Type("x", ARG_MASK_STRING), "hello world", 5 );
+    args.add( A("y", ARG_MASK_INTEGER, 6l) );
+
+    // copies share the arena
+    Arguments copy(args);
+    bool ok = (args.count()==2) && (copy.count()==2) && (copy.arena()==&arena)
+           && strcmp(args["x"].s, "hello")==0 && args["x"].length()==5
+           && strcmp(copy["x"].s, "hello")==0 && copy["x"].s != args["x"].s
+           && copy["y"].l==6l
+           && arena.info().bytes == 2*6;  // argument arrays are inline, only the strings are in the arena
+    arena.reset();
+    return ok && arena.info().bytes==0
+           ? OK
+           : FAIL;
+}
+
+TEST(arguments_grow_beyond_inline) {
+    Arguments args;
+    char name[8];
+    for(long i=0; i<20; i++) {
+        sprintf(name, "a%ld", i);
+        args.add( A(name, ARG_MASK_INTEGER, i) );
+    }
+    args.add( Type("s", ARG_MASK_STRING), "string", 6 );
+    if(args.isInline() || args.count()!=21 || args.capacity()!=32)
+        return FAIL;
+    for(long i=0; i<20; i++) {
+        sprintf(name, "a%ld", i);
+        if(args[name].l != i)
+            return FAIL;
+    }
+    return strcmp(args["s"].s, "string")==0
+           ? OK
+           : FAIL;
+}
+
+TEST(arguments_move) {
+    Arguments small;
+    small.add( Type("x", ARG_MASK_STRING), "hello", 5 );
+    const char* s = small["x"].s;
+
+    // inline arguments are relocated, the string moves with them
+    Arguments moved(std::move(small));
+    if(!moved.isInline() || moved.count()!=1 || small.count()!=0 || moved["x"].s != s)
+        return FAIL;
+
+    Arguments big(8);
+    big.add( A("y", ARG_MASK_INTEGER, 6l) );
+    moved = std::move(big);
+    return !moved.isInline() && moved.capacity()==8 && moved.count()==1 && moved["y"].l==6l
+           && big.isInline() && big.count()==0
+           ? OK
+           : FAIL;
+}
+
+TEST(arguments_own_string_values) {
+    char value[] = "kitchen";
+    Argument view = A("room", ARG_MASK_STRING, (const char*)value);
+    if(sizeof(Argument) > 16 || view.s != value || view.length() != 7)
+        return FAIL;
+
+    // adding the argument copies the string, the view does not
+    Arguments args;
+    args.add(view);
+    value[0] = 'K';
+    return strcmp(args["room"].s, "kitchen")==0 && args["room"].s != value
+           && strcmp(view.s, "Kitchen")==0
+           ? OK
+           : FAIL;
+}
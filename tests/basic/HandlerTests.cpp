@@ -99,3 +99,35 @@ TEST(handler_get_instance_function)
 }
 
 
+
+typedef Rest::InlineHandler<FakeRequest&> FakeInlineHandler;
+
+TEST(handler_inline_function)
+{
+    FakeRequest r(1);
+    FakeInlineHandler h(handler_func);
+    return (h!=nullptr && h(r)==2 && r.value==2)
+           ? OK
+           : FAIL;
+}
+
+TEST(handler_inline_lambda_wcapture)
+{
+    int rr = 4;
+    FakeRequest r(1);
+    FakeInlineHandler h([&rr](FakeRequest& r) { r.value = 2; rr=2; return r.value;});
+
+    // copies share the captured reference
+    FakeInlineHandler h2 = h;
+    return (h2(r)==rr && r.value==rr)
+           ? OK
+           : FAIL;
+}
+
+TEST(handler_inline_null)
+{
+    FakeInlineHandler h, h2(nullptr);
+    return (h==nullptr && h2==nullptr && !h && sizeof(FakeInlineHandler) < sizeof(FakeHandler))
+           ? OK
+           : FAIL;
+}
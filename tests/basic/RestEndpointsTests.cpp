@@ -354,3 +354,539 @@ TEST(endpoints_with_same_resolve)
 
     return OK;
 }
+
+TEST(endpoints_resolve_into_arena)
+{
+    Endpoints endpoints;
+    Rest::PagedPool arena(256);
+    endpoints.on("/api/echo/:msg(string|integer)/:id(integer)").PUT(echo);
+
+    for(int i=0; i<3; i++) {
+        Endpoints::Request res = endpoints.resolve(Rest::HttpPut, "/api/echo/johndoe/5", arena);
+        if(res.status!=Rest::UriMatched || res.args.arena()!=&arena || res.args.count()!=2)
+            return FAIL;
+        if(strcmp((const char*)res["msg"], "johndoe")!=0 || (long)res["id"]!=5)
+            return FAIL;
+        if(arena.info().bytes==0)
+            return FAIL;
+
+        // release the arguments of the request
+        arena.reset();
+        if(arena.info().bytes!=0 || arena.info().count!=1)
+            return FAIL;
+    }
+    return OK;
+}
+
+TEST(endpoints_resolve_materializes_arguments_once)
+{
+    Endpoints endpoints;
+    Rest::PagedPool arena(256);
+    endpoints.on("/api/echo/:msg(string)").PUT(echo);
+
+    // the string argument is copied into the arena once, then moved into the returned request
+    Endpoints::Request res = endpoints.resolve(Rest::HttpPut, "/api/echo/johndoe", arena);
+    return (res.status==Rest::UriMatched && strcmp((const char*)res["msg"], "johndoe")==0
+            && arena.info().bytes==strlen("johndoe")+1)
+        ? OK
+        : FAIL;
+}
+
+TEST(endpoints_resolve_empty_uri_fails)
+{
+    Endpoints endpoints;
+    Rest::PagedPool arena(256);
+    endpoints.on("/api/echo/:msg(string)").PUT(echo);
+
+    // the request keeps its arguments when the Uri cannot even be scanned
+    Endpoints::Request req(Rest::HttpPut, "", arena);
+    bool resolved = endpoints.getRoot().resolve(req);
+    return (!resolved && req.status==Rest::URL_FAIL_SYNTAX && req.args.arena()==&arena && req.args.count()==0)
+        ? OK
+        : FAIL;
+}
+
+TEST(endpoints_externals_roll_back)
+{
+    Endpoints endpoints1, endpoints2, endpoints3;
+
+    // the first external matches the argument but has no endpoint beyond it, the second external must start again
+    // from the same place and the arguments added by the first must be dropped
+    endpoints1.on("/api").with(endpoints2).on("user/:name(string)/status").GET(devices);
+    endpoints1.on("/api").with(endpoints3).on("user/:msg(string)/echo").GET(getbus);
+
+    Endpoints::Request res = endpoints1.resolve(Rest::HttpGet, "/api/user/johndoe/echo");
+    if(res.status!=Rest::UriMatched || !check_response(res.handler.handler, getbus))
+        return FAIL;
+    return (res.args.count()==1 && strcmp((const char*)res["msg"], "johndoe")==0)
+        ? OK
+        : FAIL;
+}
+
+TEST(endpoints_argument_positions)
+{
+    Endpoints endpoints;
+    static const Rest::ArgumentName DEV("dev"), CH("ch");
+
+    auto dev = endpoints.on("/api/devices/:dev(integer)").GET(devices);
+    auto ch = dev.on("channel/:ch(integer)").GET(slot);
+    if(dev.position(DEV)!=0 || dev.position(CH)!=-1 || ch.position(DEV)!=0 || ch.position("ch")!=1)
+        return FAIL;
+
+    Endpoints::Request res = endpoints.resolve(Rest::HttpGet, "/api/devices/5/channel/3");
+    if(res.status!=Rest::UriMatched || !check_response(res.handler.handler, slot))
+        return FAIL;
+    return ((long)res[DEV]==5 && (long)res[CH]==3 && (long)res.args[ch.position(CH)]==3
+            && res.args.indexOf(CH)==1 && res[Rest::ArgumentName("missing")].type==0)
+        ? OK
+        : FAIL;
+}
+
+int channel_typed(RestRequest &request, long dev, long ch) {
+    request.response = std::to_string(dev) + "/" + std::to_string(ch);
+    return 200;
+}
+
+int name_typed(RestRequest &request, long dev, const char* name) {
+    request.response = std::to_string(dev) + " " + name;
+    return 200;
+}
+
+int level_typed(RestRequest &request, long dev, double level) {
+    request.response = std::to_string(dev) + " " + std::to_string(level);
+    return 200;
+}
+
+TEST(endpoints_typed_handler)
+{
+    Endpoints endpoints;
+    endpoints.on("/api/dev/:dev(integer)/ch/:ch(integer)").GET(channel_typed);
+    endpoints.on("/api/dev/:dev(integer)/name/:name(string)").PUT(name_typed);
+    endpoints.on("/api/dev/:dev(integer)/level/:level(number)").PUT(level_typed);
+
+    Endpoints::Request res = endpoints.resolve(Rest::HttpGet, "/api/dev/5/ch/3");
+    if(!res)
+        return FAIL;
+    RestRequest rr(res);
+    if(res.handler(rr)!=200 || rr.response!="5/3")
+        return FAIL;
+
+    res = endpoints.resolve(Rest::HttpPut, "/api/dev/5/name/kitchen");
+    RestRequest rn(res);
+    if(!res || res.handler(rn)!=200 || rn.response!="5 kitchen")
+        return FAIL;
+
+    // an integer is received by a double parameter as well as a real
+    res = endpoints.resolve(Rest::HttpPut, "/api/dev/5/level/2");
+    RestRequest rl(res);
+    if(!res || res.handler(rl)!=200 || rl.response!="5 2.000000")
+        return FAIL;
+    res = endpoints.resolve(Rest::HttpPut, "/api/dev/5/level/2.5");
+    RestRequest rl2(res);
+    return (res && res.handler(rl2)==200 && rl2.response=="5 2.500000")
+        ? OK
+        : FAIL;
+}
+
+int ch_typed(RestRequest &request, long ch) {
+    request.response = std::to_string(ch);
+    return 200;
+}
+
+TEST(endpoints_typed_handler_with)
+{
+    Endpoints parent, child, files;
+
+    // the arguments of the parent come first, the handler only receives those of its own endpoint
+    parent.on("/api/dev/:dev(integer)").with(child).on("ch/:ch(integer)").GET(ch_typed);
+    child.on("name/:id(integer)/:name(string)").GET(name_typed);
+    parent.on("/api/files/:dev(integer)").with(files).on("f/:ch(integer)/*").GET(ch_typed);
+
+    Endpoints::Request res = parent.resolve(Rest::HttpGet, "/api/dev/5/ch/3");
+    RestRequest rr(res);
+    if(!res || res.args.count()!=2 || res.handler(rr)!=200 || rr.response!="3")
+        return FAIL;
+
+    res = parent.resolve(Rest::HttpGet, "/api/dev/5/name/7/kitchen");
+    RestRequest rn(res);
+    if(!res || res.handler(rn)!=200 || rn.response!="7 kitchen")
+        return FAIL;
+
+    // the rest of the Uri matched by a wildcard is not passed on
+    res = parent.resolve(Rest::HttpGet, "/api/files/5/f/9/a/b");
+    RestRequest rw(res);
+    return (res.status==Rest::UriMatchedWildcard && res.args.count()==3 && res.handler(rw)==200
+            && rw.response=="9")
+        ? OK
+        : FAIL;
+}
+
+TEST(endpoints_typed_handler_mismatch)
+{
+    Endpoints endpoints;
+
+    // string argument cannot be received as a long
+    auto name = endpoints.on("/api/dev/:dev(integer)/name/:name(string)").GET(channel_typed);
+    if(name.error()!=Rest::InvalidParameterType)
+        return FAIL;
+
+    // a double parameter cannot hold a string
+    auto level = endpoints.on("/api/dev/:dev(integer)/level/:level(number|string)").GET(level_typed);
+    if(level.error()!=Rest::InvalidParameterType)
+        return FAIL;
+
+    // wrong number of parameters
+    auto dev = endpoints.on("/api/dev/:dev(integer)").GET(channel_typed);
+    if(dev.error()!=Rest::InvalidHandler)
+        return FAIL;
+
+    Endpoints::Request res = endpoints.resolve(Rest::HttpGet, "/api/dev/5/name/kitchen");
+    return (res.status==Rest::NoHandler)
+        ? OK
+        : FAIL;
+}
+
+TEST(endpoints_inline_handlers)
+{
+    typedef Rest::Endpoints< Rest::InlineHandler<RestRequest&> > InlineEndpoints;
+    InlineEndpoints endpoints;
+    std::string suffix = "!";
+    const std::string* psuffix = &suffix;
+    endpoints.on("/api/devices").GET(devices);
+    endpoints.on("/api/dev/:dev(integer)/ch/:ch(integer)").GET(channel_typed);
+    endpoints.on("/api/echo").GET([psuffix](RestRequest& request) { request.response = "echo" + *psuffix; return 200; });
+
+    if(sizeof(InlineEndpoints::Handler) >= sizeof(Endpoints::Handler))
+        return FAIL;
+
+    InlineEndpoints::Request res = endpoints.resolve(Rest::HttpGet, "/api/dev/5/ch/3");
+    RestRequest rr(res);
+    if(!res || res.handler(rr)!=200 || rr.response!="5/3")
+        return FAIL;
+
+    res = endpoints.resolve(Rest::HttpGet, "/api/echo");
+    RestRequest re(res);
+    if(!res || res.handler(re)!=200 || re.response!="echo!")
+        return FAIL;
+
+    res = endpoints.resolve(Rest::HttpPut, "/api/devices");
+    return (res.status==Rest::NoHandler && !res)
+        ? OK
+        : FAIL;
+}
+
+TEST(endpoints_function_pointers)
+{
+    typedef Rest::FunctionEndpoints<RestRequest&> FunctionEndpoints;
+    FunctionEndpoints endpoints, endpoints2;
+    endpoints.on("/api/devices").GET(devices).PUT(slots);
+    endpoints.on("/api/bus").with(endpoints2).on("i2c/:bus(integer)").GET(getbus);
+    endpoints.freeze();
+
+    if(sizeof(FunctionEndpoints::Handler) >= sizeof(Endpoints::Handler))
+        return FAIL;
+
+    FunctionEndpoints::Request res = endpoints.resolve(Rest::HttpPut, "/api/devices");
+    if(!res || res.handler!=slots)
+        return FAIL;
+    res = endpoints.resolve(Rest::HttpGet, "/api/bus/i2c/1");
+    return (res && res.handler==getbus && (long)res["bus"]==1)
+        ? OK
+        : FAIL;
+}
+
+TEST(endpoints_sparse_methods)
+{
+    Endpoints endpoints;
+    const Rest::HttpMethod HttpPurge = (Rest::HttpMethod)(Rest::HttpCustom + 0);
+    auto node = endpoints.on("/api/devices").PUT(slots).HEAD(slot);
+    node.attach(HttpPurge, getbus);
+    node.ANY(devices);
+
+    // only the verbs with handlers take up space in the node
+    node.PUT(slot);
+    auto bare = endpoints.on("/api/bare");
+    if(bare->handlers!=nullptr || bare->handle(Rest::HttpGet)!=nullptr)
+        return FAIL;
+
+    Endpoints::Request res = endpoints.resolve(Rest::HttpHead, "/api/devices");
+    if(!res || !check_response(res.handler.handler, slot))
+        return FAIL;
+    res = endpoints.resolve(Rest::HttpPut, "/api/devices");
+    if(!res || !check_response(res.handler.handler, slot))
+        return FAIL;
+    res = endpoints.resolve(HttpPurge, "/api/devices");
+    if(!res || !check_response(res.handler.handler, getbus))
+        return FAIL;
+    res = endpoints.resolve(Rest::HttpDelete, "/api/devices");
+    if(!res || !check_response(res.handler.handler, devices))
+        return FAIL;
+
+    // custom verbs are not included in ANY
+    res = endpoints.resolve((Rest::HttpMethod)(Rest::HttpCustom + 1), "/api/devices");
+    return (res.status==Rest::NoHandler)
+        ? OK
+        : FAIL;
+}
+
+TEST(endpoints_method_not_allowed)
+{
+    Endpoints endpoints;
+    endpoints.on("/api/devices").GET(devices).PUT(devices);
+    endpoints.on("/api/devices/:dev(integer)/slots").GET(slots);
+
+    // matched the endpoint, but not the method
+    Endpoints::Request res = endpoints.resolve(Rest::HttpPost, "/api/devices");
+    if(res.status!=Rest::NoHandler || !res.allows(Rest::HttpGet) || !res.allows(Rest::HttpPut) || res.allows(Rest::HttpPost))
+        return FAIL;
+
+    // gives up before matching the rest of the Uri since nothing below /api/devices/5 handles a PUT
+    res = endpoints.resolve(Rest::HttpPut, "/api/devices/5/slots/unknown/path");
+    if(res.status!=Rest::NoHandler || !res.allows(Rest::HttpGet) || res.allows(Rest::HttpPut))
+        return FAIL;
+
+    // attaching a handler makes the method reachable again
+    endpoints.on("/api/devices/:dev(integer)/slots").PUT(slot);
+    res = endpoints.resolve(Rest::HttpPut, "/api/devices/5/slots");
+    return (res && check_response(res.handler.handler, slot))
+        ? OK
+        : FAIL;
+}
+
+TEST(endpoints_many_arguments)
+{
+    Endpoints endpoints;
+    std::string expr = "/api", uri = "/api";
+    char part[32];
+    for(int i=0; i<40; i++) {
+        sprintf(part, "/p%d/:a%d(integer)", i, i);
+        expr += part;
+        sprintf(part, "/p%d/%d", i, i*10);
+        uri += part;
+    }
+    if(endpoints.on(expr.c_str()).GET(devices).error()!=0)
+        return FAIL;
+
+    Endpoints::Request res = endpoints.resolve(Rest::HttpGet, uri.c_str());
+    if(!res || res.args.count()!=40)
+        return FAIL;
+    for(int i=0; i<40; i++) {
+        sprintf(part, "a%d", i);
+        if((long)res[part]!=i*10)
+            return FAIL;
+    }
+    return OK;
+}
+
+TEST(endpoints_static_routes)
+{
+    Endpoints endpoints;
+    endpoints.on("/api/devices").GET(devices);
+    endpoints.on("/api/devices/:dev(integer)").GET(slot);
+    endpoints.on("/api/files/*").GET(getbus);
+
+    Endpoints::Request res = endpoints.resolve(Rest::HttpGet, "/API/Devices/?verbose=1");
+    if(!res || !check_response(res.handler.handler, devices) || endpoints.routes.size()!=1)
+        return FAIL;
+
+    // routes added later are found in the table too
+    endpoints.on("/api/system/status").GET(slots).PUT(slot);
+    res = endpoints.resolve(Rest::HttpPut, "api/system/status");
+    if(!res || !check_response(res.handler.handler, slot) || endpoints.routes.size()!=2)
+        return FAIL;
+
+    // falls back to the node graph for anything not in the table
+    res = endpoints.resolve(Rest::HttpGet, "/api/devices/5");
+    if(!res || !check_response(res.handler.handler, slot) || (long)res["dev"]!=5)
+        return FAIL;
+    res = endpoints.resolve(Rest::HttpGet, "/api/files/boot");
+    if(res.status!=Rest::UriMatchedWildcard || !check_response(res.handler.handler, getbus))
+        return FAIL;
+    res = endpoints.resolve(Rest::HttpGet, "/api//devices");
+    if(res.status!=Rest::NoEndpoint)
+        return FAIL;
+    res = endpoints.resolve(Rest::HttpPost, "/api/system/status");
+    return (res.status==Rest::NoHandler && res.allows(Rest::HttpPut))
+        ? OK
+        : FAIL;
+}
+
+TEST(endpoints_static_routes_attach)
+{
+    Endpoints endpoints;
+    char uri[64];
+    for(int i=0; i<100; i++) {
+        sprintf(uri, "/api/dev%d/status", i);
+        endpoints.on(uri).GET(devices);
+        Endpoints::Request res = endpoints.resolve(Rest::HttpGet, uri);
+        if(!res || !check_response(res.handler.handler, devices) || endpoints.routes.size()!=(size_t)i+1)
+            return FAIL;
+    }
+
+    // attaching another method to an endpoint in the table does not add it twice
+    endpoints.on("/api/dev7/status").PUT(slot);
+    Endpoints::Request res = endpoints.resolve(Rest::HttpPut, "/api/dev7/status");
+    if(!res || !check_response(res.handler.handler, slot) || endpoints.routes.size()!=100)
+        return FAIL;
+
+    // removing a handler leaves the route in the table, the node graph reports the methods still handled
+    endpoints.on("/api/dev7/status").GET(Endpoints::Handler());
+    res = endpoints.resolve(Rest::HttpGet, "/api/dev7/status");
+    return (res.status==Rest::NoHandler && res.allows(Rest::HttpPut) && !res.allows(Rest::HttpGet))
+        ? OK
+        : FAIL;
+}
+
+TEST(endpoints_inline_literals)
+{
+    Endpoints endpoints;
+    endpoints.on("/api/dev/:id(integer)/config").GET(devices);
+    endpoints.on("/api/dev/:id(integer)/configur").GET(slot);
+    endpoints.on("/api/dev/:id(integer)/configuration").GET(slots);
+    endpoints.on("/api/dev/:id(integer)/5").GET(getbus);
+
+    // short words are matched inline, the long one and the ones sharing its first 8 characters must not mix
+    Endpoints::Request res = endpoints.resolve(Rest::HttpGet, "/API/Dev/3/CONFIG");
+    if(!res || !check_response(res.handler.handler, devices))
+        return FAIL;
+    res = endpoints.resolve(Rest::HttpGet, "/api/dev/3/configur");
+    if(!res || !check_response(res.handler.handler, slot))
+        return FAIL;
+    res = endpoints.resolve(Rest::HttpGet, "/api/dev/3/Configuration");
+    if(!res || !check_response(res.handler.handler, slots))
+        return FAIL;
+    res = endpoints.resolve(Rest::HttpGet, "/api/dev/3/configu");
+    if(res.status!=Rest::NoEndpoint)
+        return FAIL;
+    res = endpoints.resolve(Rest::HttpGet, "/api/dev/3/configurations");
+    return (res.status==Rest::NoEndpoint)
+        ? OK
+        : FAIL;
+}
+
+// the literals of the node below /api, in the order they are compared
+static std::string adapt_order(Endpoints& endpoints)
+{
+    std::string order;
+    for(auto lit = endpoints.ep_head->literals->nextNode->literals; lit != nullptr; lit = lit->next) {
+        if(!order.empty())
+            order += ',';
+        order += endpoints.getDictionary().get(lit->id);
+    }
+    return order;
+}
+
+TEST(endpoints_adaptive_literals)
+{
+    Endpoints endpoints, restarted;
+    for(auto ep: { &endpoints, &restarted }) {
+        ep->on("/api/alpha/:n(integer)").GET(devices);
+        ep->on("/api/beta/:n(integer)").GET(slot);
+        ep->on("/api/gamma/:n(integer)").GET(slots);
+    }
+
+    endpoints.adapt(true);
+    for(int i=0; i < 5; i++)
+        endpoints.resolve(Rest::HttpGet, "/api/gamma/1");
+    for(int i=0; i < 2; i++)
+        endpoints.resolve(Rest::HttpGet, "/api/Beta/1");
+    std::string profile = endpoints.saveProfile();
+    if(profile.find("api/gamma\t5\n") == std::string::npos || profile.find("api/beta\t2\n") == std::string::npos
+       || profile.find("alpha") != std::string::npos)
+        return FAIL;
+
+    endpoints.reorder();
+    if(adapt_order(endpoints) != "gamma,beta,alpha")
+        return FAIL;
+
+    // the profile gives the same order after a restart
+    if(restarted.loadProfile(profile.c_str()) != 3 || adapt_order(restarted) != "gamma,beta,alpha")
+        return FAIL;
+
+    // frozen endpoints count hits too, a reorder is due after every 10 resolves but only done when asked for
+    restarted.freeze();
+    restarted.adapt(true, 10);
+    for(int i=0; i < 10; i++) {
+        if(restarted.reorderDue())
+            return FAIL;
+        restarted.resolve(Rest::HttpGet, "/api/alpha/1");
+    }
+    if(!restarted.reorderDue() || adapt_order(restarted) != "gamma,beta,alpha")
+        return FAIL;
+    restarted.reorder();
+    if(restarted.reorderDue() || !restarted.isFrozen() || adapt_order(restarted) != "alpha,gamma,beta")
+        return FAIL;
+    Endpoints::Request res = restarted.resolve(Rest::HttpGet, "/api/alpha/1");
+    return (res && check_response(res.handler.handler, devices))
+        ? OK
+        : FAIL;
+}
+
+TEST(endpoints_scoped_dictionaries)
+{
+    Endpoints a, b;
+    a.on("/api/tenant-a/status").GET(getbus);
+    b.on("/api/tenant-b/status").GET(getbus);
+
+    // each collection only holds the words of its own endpoints
+    if(a.getDictionary() == b.getDictionary() || a.getDictionary().find("tenant-b") >= 0
+       || b.getDictionary().find("tenant-b") < 0 || b.getDictionary().size() != 3)
+        return FAIL;
+    if(a.resolve(Rest::HttpGet, "/api/tenant-b/status").status != Rest::NoEndpoint
+       || !a.resolve(Rest::HttpGet, "/api/TENANT-A/status"))
+        return FAIL;
+
+    // collections given the same dictionary share words, the words are freed with the last reference
+    Rest::Dictionary shared;
+    {
+        Endpoints c(shared), d(shared);
+        c.on("/api/sensor/:id(integer)/temperature").GET(getbus);
+        d.on("/api/sensor/:id(integer)/temperatureOffset").GET(slot);
+        if(shared.refs() != 3 || shared.find("temperature") < 0 || shared.find("temperatureOffset") < 0
+           || c.getDictionary() != d.getDictionary())
+            return FAIL;
+        Endpoints::Request rc = c.resolve(Rest::HttpGet, "/api/sensor/5/temperature");
+        Endpoints::Request rd = d.resolve(Rest::HttpGet, "/api/sensor/7/TemperatureOffset");
+        if(!rc || !rd || (long)rc["id"] != 5 || (long)rd["id"] != 7 || !check_response(rd.handler.handler, slot))
+            return FAIL;
+    }
+    return (shared.refs() == 1)
+        ? OK
+        : FAIL;
+}
+
+TEST(endpoints_move)
+{
+    Endpoints a;
+    a.on("/api/devices").GET(devices);
+    a.on("/api/devices/:dev(integer)").GET(slot);
+    a.freeze();
+
+    // the endpoints, their words and the frozen table go to the new instance
+    Endpoints b(std::move(a));
+    Endpoints::Request res = b.resolve(Rest::HttpGet, "/api/devices/5");
+    if(!res || !check_response(res.handler.handler, slot) || (long)res["dev"]!=5 || !b.isFrozen())
+        return FAIL;
+    if(!b.resolve(Rest::HttpGet, "/api/devices") || b.getDictionary().find("devices") < 0)
+        return FAIL;
+
+    // the moved from instance is empty but can still be used
+    if(a.isFrozen() || a.getDictionary() == b.getDictionary() || a.getDictionary().find("devices") >= 0
+       || a.resolve(Rest::HttpGet, "/api/devices").status!=Rest::URL_FAIL_NULL_ROOT)
+        return FAIL;
+    a.on("/api/status").GET(slots);
+    res = a.resolve(Rest::HttpGet, "/api/status");
+    if(!res || !check_response(res.handler.handler, slots) || a.resolve(Rest::HttpGet, "/api/devices"))
+        return FAIL;
+
+    // assigning releases the endpoints that were there before
+    b = std::move(a);
+    res = b.resolve(Rest::HttpGet, "/api/status");
+    if(!res || !check_response(res.handler.handler, slots) || b.isFrozen()
+       || b.resolve(Rest::HttpGet, "/api/devices"))
+        return FAIL;
+    a.on("/api/devices").GET(devices);
+    return a.resolve(Rest::HttpGet, "/api/devices")
+        ? OK
+        : FAIL;
+}
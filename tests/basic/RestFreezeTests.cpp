@@ -0,0 +1,404 @@
+//
+// Created by Colin MacKenzie on 2019-06-02.
+//
+
+#include <catch.hpp>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include <Endpoints.h>
+#include "requests.h"
+
+#define TEST(x) TEST_CASE( #x, "[freeze]" )
+
+typedef Rest::Handler< RestRequest& > FreezeHandler;
+typedef Rest::Endpoints<FreezeHandler> FreezeEndpoints;
+
+static int fz_devices(RestRequest &request) { request.response = "devices"; return 200; }
+static int fz_device(RestRequest &request) { request.response = "device"; return 200; }
+static int fz_channel(RestRequest &request) { request.response = "channel"; return 200; }
+static int fz_name(RestRequest &request) { request.response = "name"; return 200; }
+static int fz_files(RestRequest &request) { request.response = "files"; return 200; }
+
+static void fz_add_routes(FreezeEndpoints& endpoints)
+{
+    endpoints.on("/api/devices").GET(fz_devices);
+    endpoints.on("/api/devices/:dev(integer)").GET(fz_device).PUT(fz_device);
+    endpoints.on("/api/devices/:dev(integer)/channel/:ch(integer)").GET(fz_channel);
+    endpoints.on("/api/devices/:dev(integer)/name/:name(string)").GET(fz_name);
+    endpoints.on("/api/files/*").GET(fz_files);
+    endpoints.on("/api/system/status/network").GET(fz_devices);
+}
+
+static std::string fz_invoke(FreezeEndpoints::Request& r)
+{
+    if(!r)
+        return std::string("status ") + std::to_string(r.status);
+    RestRequest rr(r);
+    r.handler(rr);
+    return rr.response;
+}
+
+// resolve every Uri with each method against the node graph and the frozen table and require the same results
+template<size_t N>
+static void fz_compare(FreezeEndpoints& graph, FreezeEndpoints& frozen, const char* const (&uris)[N],
+                       std::initializer_list<Rest::HttpMethod> methods)
+{
+    for(auto uri: uris) {
+        for(auto method: methods) {
+            FreezeEndpoints::Request g = graph.resolve(method, uri);
+            FreezeEndpoints::Request f = frozen.resolve(method, uri);
+            INFO(uri);
+            REQUIRE(g.status == f.status);
+            REQUIRE(fz_invoke(g) == fz_invoke(f));
+            REQUIRE(g.args.count() == f.args.count());
+            for(int i=0; i<g.args.count(); i++) {
+                REQUIRE(strcmp(g.args[i].name(), f.args[i].name())==0);
+                REQUIRE(g.args[i] == f.args[i]);
+            }
+        }
+    }
+}
+
+static const char* fz_uris[] = {
+        "/api/devices",
+        "/api/devices/5",
+        "/api/devices/5/channel/3",
+        "/api/devices/5/name/kitchen",
+        "/api/devices/kitchen",
+        "/api/devices/5/channel",
+        "/api/files/config/display",
+        "/api/system/status/network",
+        "/api/system/status",
+        "/api/unknown",
+        "/api/devices/5/unknown/3"
+};
+
+TEST(freeze_resolves_same_as_node_graph)
+{
+    FreezeEndpoints graph, frozen;
+    fz_add_routes(graph);
+    fz_add_routes(frozen);
+    REQUIRE(frozen.freeze());
+    REQUIRE(frozen.isFrozen());
+    REQUIRE(!graph.isFrozen());
+
+    fz_compare(graph, frozen, fz_uris, { Rest::HttpGet, Rest::HttpPut });
+}
+
+TEST(freeze_resolves_arguments)
+{
+    FreezeEndpoints endpoints;
+    fz_add_routes(endpoints);
+    endpoints.freeze();
+
+    FreezeEndpoints::Request r = endpoints.resolve(Rest::HttpGet, "/api/devices/7/channel/2");
+    REQUIRE(r.status == Rest::UriMatched);
+    REQUIRE(fz_invoke(r) == "channel");
+    REQUIRE((long)r["dev"] == 7);
+    REQUIRE((long)r["ch"] == 2);
+
+    r = endpoints.resolve(Rest::HttpGet, "/api/files/config/display");
+    REQUIRE(r.status == Rest::UriMatchedWildcard);
+    REQUIRE(strcmp((const char*)r["_url"], "config/display")==0);
+}
+
+TEST(freeze_table_is_smaller_than_node_graph)
+{
+    FreezeEndpoints endpoints;
+    fz_add_routes(endpoints);
+    endpoints.freeze();
+    REQUIRE(endpoints.frozen->size() > 1);
+    REQUIRE(endpoints.frozen->bytes() < endpoints.pool.info().bytes);
+}
+
+TEST(freeze_thaws_when_endpoints_added)
+{
+    FreezeEndpoints endpoints;
+    fz_add_routes(endpoints);
+    endpoints.freeze();
+    endpoints.on("/api/version").GET(fz_files);
+    REQUIRE(!endpoints.isFrozen());
+
+    FreezeEndpoints::Request r = endpoints.resolve(Rest::HttpGet, "/api/version");
+    REQUIRE(fz_invoke(r) == "files");
+
+    endpoints.freeze();
+    r = endpoints.resolve(Rest::HttpGet, "/api/version");
+    REQUIRE(fz_invoke(r) == "files");
+}
+
+TEST(freeze_resolves_into_externals)
+{
+    FreezeEndpoints endpoints1, endpoints2;
+    endpoints1
+            .on("/api")
+            .with(endpoints2)
+            .on("echo/:msg(string|integer)")
+            .PUT(fz_name);
+    endpoints1.freeze();
+    endpoints2.freeze();
+
+    FreezeEndpoints::Request r = endpoints1.resolve(Rest::HttpPut, "/api/echo/johndoe");
+    REQUIRE(r.status == Rest::UriMatched);
+    REQUIRE(fz_invoke(r) == "name");
+}
+
+TEST(freeze_hashes_nodes_with_many_literals)
+{
+    char uri[64];
+    FreezeEndpoints endpoints;
+    for(int i=0; i<200; i++) {
+        sprintf(uri, "/devices/sensor-%03d/status", i);
+        endpoints.on(uri).GET(fz_device);
+    }
+    endpoints.on("/devices/:name(string)").GET(fz_name);
+    endpoints.freeze();
+
+    for(int i=0; i<200; i++) {
+        sprintf(uri, "/devices/SENSOR-%03d/status", i);
+        FreezeEndpoints::Request r = endpoints.resolve(Rest::HttpGet, uri);
+        INFO(uri);
+        REQUIRE(r.status == Rest::UriMatched);
+        REQUIRE(fz_invoke(r) == "device");
+    }
+
+    // not one of the literals so falls through to the string argument
+    FreezeEndpoints::Request r = endpoints.resolve(Rest::HttpGet, "/devices/sensor-200");
+    REQUIRE(fz_invoke(r) == "name");
+    REQUIRE(strcmp((const char*)r["name"], "sensor-200")==0);
+}
+
+TEST(freeze_resolves_unterminated_uri)
+{
+    // resolve from a buffer of the request line without terminating the Uri
+    const char* line = "/api/devices/5/channel/3 HTTP/1.1";
+    const char* query = "/api/devices/5/channel/3?units=C";
+    const char* wild = "/api/files/config/display?raw=1";
+    FreezeEndpoints graph, frozen;
+    fz_add_routes(graph);
+    fz_add_routes(frozen);
+    frozen.freeze();
+
+    for(auto endpoints: { &graph, &frozen }) {
+        FreezeEndpoints::Request r = endpoints->resolve(Rest::HttpGet, line, 24);
+        REQUIRE(r.status == Rest::UriMatched);
+        REQUIRE(fz_invoke(r) == "channel");
+        REQUIRE((long)r["ch"] == 3);
+
+        r = endpoints->resolve(Rest::HttpGet, line, 14);
+        REQUIRE(fz_invoke(r) == "device");
+        REQUIRE((long)r["dev"] == 5);
+
+        r = endpoints->resolve(Rest::HttpGet, query, strlen(query));
+        REQUIRE(fz_invoke(r) == "channel");
+        REQUIRE((long)r["ch"] == 3);
+
+        r = endpoints->resolve(Rest::HttpGet, wild, strlen(wild));
+        REQUIRE(r.status == Rest::UriMatchedWildcard);
+        REQUIRE(strcmp((const char*)r["_url"], "config/display")==0);
+
+        r = endpoints->resolve(Rest::HttpGet, wild, 21);
+        REQUIRE(r.status == Rest::UriMatchedWildcard);
+        REQUIRE(strcmp((const char*)r["_url"], "config/dis")==0);
+    }
+}
+
+TEST(freeze_gives_up_on_unreachable_method)
+{
+    FreezeEndpoints graph, frozen;
+    fz_add_routes(graph);
+    fz_add_routes(frozen);
+    auto channel = frozen.on("/api/devices/:dev(integer)/channel/:ch(integer)");
+    frozen.freeze();
+
+    for(auto endpoints: { &graph, &frozen }) {
+        // no endpoint below /api/devices/5 handles a POST
+        FreezeEndpoints::Request r = endpoints->resolve(Rest::HttpPost, "/api/devices/5/channel/3");
+        REQUIRE(r.status == Rest::NoHandler);
+        REQUIRE(r.args.count() == 0);
+        REQUIRE(r.allows(Rest::HttpGet));
+        REQUIRE(r.allows(Rest::HttpPut));
+        REQUIRE(!r.allows(Rest::HttpPost));
+
+        r = endpoints->resolve(Rest::HttpPut, "/api/devices/5/channel/3");
+        REQUIRE(r.status == Rest::NoHandler);
+        REQUIRE(r.allows(Rest::HttpGet));
+        REQUIRE(!r.allows(Rest::HttpPut));
+    }
+
+    // attaching a handler to a node keeps the table but updates the methods it can reach
+    channel.POST(fz_name);
+    REQUIRE(frozen.isFrozen());
+    FreezeEndpoints::Request r = frozen.resolve(Rest::HttpPost, "/api/devices/5/channel/3");
+    REQUIRE(fz_invoke(r) == "name");
+}
+
+TEST(freeze_skips_chains_of_literals)
+{
+    const char* uris[] = {
+            "/api/v1/system/network/status",
+            "/api/v1/system/network/STATUS",
+            "/api/v1/system/network/status/",
+            "/api/v1/system/network/status/extra",
+            "/api/v1/system/network",
+            "/api/v1/system/network/",
+            "/api/v1/system/net",
+            "/api/v1/system/networks/status",
+            "/api/v1/system/network/state",
+            "/api/v1/system/network/statusx",
+            "/api/v1/system/network/status?verbose=1",
+            "/api/v1/system/power/level",
+            "/api/v1/system/power/5",
+            "/api/v2/files/config/display",
+            "/api/v2/files",
+            "/api/v1",
+            "/api"
+    };
+    FreezeEndpoints graph, frozen;
+    for(auto endpoints: { &graph, &frozen }) {
+        endpoints->on("/api/v1/system/network/status").GET(fz_devices);
+        endpoints->on("/api/v1/system/power/level").GET(fz_channel);
+        endpoints->on("/api/v1/system/power/:level(integer)").PUT(fz_device);
+        endpoints->on("/api/v2/files/*").GET(fz_files);
+    }
+    frozen.freeze();
+
+    fz_compare(graph, frozen, uris, { Rest::HttpGet, Rest::HttpPut });
+
+    // a chain ending in a buffer that is not terminated
+    const char* line = "/api/v1/system/network/status HTTP/1.1";
+    FreezeEndpoints::Request r = frozen.resolve(Rest::HttpGet, line, 29);
+    REQUIRE(fz_invoke(r) == "devices");
+    r = frozen.resolve(Rest::HttpGet, line, 27);
+    REQUIRE(r.status == Rest::NoEndpoint);
+}
+
+TEST(freeze_shares_identical_subtrees)
+{
+    FreezeEndpoints graph, frozen;
+    char prefix[64];
+    for(auto endpoints: { &graph, &frozen }) {
+        for(int i=0; i < 50; i++) {
+            sprintf(prefix, "/api/devices/dev%d", i);
+            auto device = endpoints->on(prefix);
+            device.on("status").GET(fz_devices);
+            device.on("config").GET(fz_device).PUT(fz_device);
+            device.on("reset").POST(fz_name);
+            device.on("channels/:n(integer)").GET(fz_channel);
+        }
+        // same literals but a different handler, so not shared
+        endpoints->on("/api/devices/hub/status").GET(fz_files);
+    }
+    frozen.freeze();
+
+    // every device shares the table entries of the first device
+    REQUIRE(frozen.frozen->shared() >= 49*6);
+    REQUIRE(frozen.frozen->size() < 20);
+
+    const char* uris[] = {
+            "/api/devices/dev0/status",
+            "/api/devices/dev7/config",
+            "/api/devices/dev49/reset",
+            "/api/devices/dev12/channels/3",
+            "/api/devices/dev50/status",
+            "/api/devices/hub/status",
+            "/api/devices/hub/config"
+    };
+    fz_compare(graph, frozen, uris, { Rest::HttpGet, Rest::HttpPut, Rest::HttpPost });
+
+    // a handler attached to one device after freezing applies only to that device
+    frozen.on("/api/devices/dev7/status").GET(fz_files);
+    auto dev8 = frozen.on("/api/devices/dev8/status");
+    frozen.freeze();
+    dev8.PUT(fz_channel);
+    REQUIRE(frozen.isFrozen());
+    FreezeEndpoints::Request r = frozen.resolve(Rest::HttpGet, "/api/devices/dev7/status");
+    REQUIRE(fz_invoke(r) == "files");
+    r = frozen.resolve(Rest::HttpPut, "/api/devices/dev8/status");
+    REQUIRE(fz_invoke(r) == "channel");
+    r = frozen.resolve(Rest::HttpPut, "/api/devices/dev9/status");
+    REQUIRE(r.status == Rest::NoHandler);
+}
+
+static void fz_add_fanout(FreezeEndpoints& endpoints, int n)
+{
+    char uri[96];
+    for(int i=0; i < n; i++) {
+        sprintf(uri, "/api/sensors/sensor-group-%d/read", i);
+        endpoints.on(uri).GET(fz_channel);
+        sprintf(uri, "/api/Sensor%d/:ch(integer)", i);
+        endpoints.on(uri).GET(fz_device);
+    }
+}
+
+TEST(freeze_matches_literal_prefixes)
+{
+    const char* uris[] = {
+            "/api/sensor3/1",
+            "/api/SENSOR17/2",
+            "/api/sensor/3",
+            "/api/sensor170/4",
+            "/api/devices",
+            "/api/sensors/sensor-group-11/read",
+            "/api/sensors/SENSOR-GROUP-9/read",
+            "/api/sensors/sensor-group-1/read",
+            "/api/sensors/sensor-group-19x/read",
+            "/api/sensors/sensor-group-/read",
+            "/api/sensors/sensor-group-5"
+    };
+    FreezeEndpoints graph, frozen;
+    fz_add_fanout(graph, 20);
+    fz_add_fanout(frozen, 20);
+    graph.on("/api/devices").GET(fz_devices);
+    frozen.on("/api/devices").GET(fz_devices);
+    frozen.freeze(FreezeEndpoints::FrozenTable::PrefixMatch);
+    REQUIRE(frozen.frozen->matchStrategy() == FreezeEndpoints::FrozenTable::PrefixMatch);
+
+    fz_compare(graph, frozen, uris, { Rest::HttpGet });
+}
+
+// run with: basic-tests "[benchmark]"
+TEST_CASE("freeze_literal_match_benchmark", "[.][benchmark]")
+{
+    typedef FreezeEndpoints::FrozenTable Table;
+
+    // scan the segments up front so only matching the literals is timed
+    std::vector<std::string> words;
+    for(int i=0; i < 64; i++)
+        words.push_back("Sensor" + std::to_string(i));
+    words.push_back("missing");
+    std::vector<Rest::Token> tokens(words.size());
+    for(size_t i=0; i < words.size(); i++) {
+        const char* p = words[i].c_str();
+        tokens[i].scan(&p, false);
+    }
+    Rest::Token api;
+    const char* p = "api";
+    api.scan(&p, false);
+
+    for(int n: { 4, 8, 16, 32, 63 }) {
+        for(auto strategy: { Table::HashMatch, Table::PrefixMatch }) {
+            FreezeEndpoints endpoints;
+            fz_add_fanout(endpoints, n);
+            endpoints.freeze(strategy);
+            const Table& table = *endpoints.frozen;
+            const Table::Node& fanout = table.node(table.findLiteral(table.node(0), api)->next);
+
+            std::string name = std::to_string(n) + " literals, "
+                    + ((strategy == Table::HashMatch) ? "hash" : "prefix");
+            long matched = 0;
+            BENCHMARK(name) {
+                for(int i=0; i < 1000000; i++) {
+                    // every 8th segment misses
+                    const Rest::Token& t = tokens[(i & 7) == 7 ? 64 : i % n];
+                    if(table.findLiteral(fanout, t) != nullptr)
+                        matched++;
+                }
+            }
+            REQUIRE(matched > 0);
+        }
+    }
+}
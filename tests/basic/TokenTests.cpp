@@ -0,0 +1,159 @@
+//
+// Created by Colin MacKenzie on 2019-06-04.
+//
+
+#include <catch.hpp>
+#include <cstring>
+
+#include <Token.h>
+
+#define TEST(x) TEST_CASE( #x, "[token]" )
+
+using Rest::Token;
+
+static void token_init_index()
+{
+    if(Rest::literals_index == nullptr)
+        Rest::literals_index = binbag_create(128, 1.5);
+}
+
+TEST(token_hash_is_case_insensitive)
+{
+    const char* uri = "Sensor-01/status";
+    Token t;
+    REQUIRE(t.scan(&uri, 0));
+    REQUIRE(t.id == TID_IDENTIFIER);
+    REQUIRE(t.hash == Rest::hash_nocase("sensor-01"));
+    REQUIRE(t.hash == Rest::hash_nocase("SENSOR-01"));
+    REQUIRE(t.hash != Rest::hash_nocase("sensor-02"));
+}
+
+TEST(token_resolve_scan_views_input)
+{
+    const char* input = "/Devices/Colin MacKenzie/status";
+    const char* uri = input;
+    Token t;
+    REQUIRE(t.scan(&uri, 0));
+    REQUIRE(t.id == '/');
+
+    REQUIRE(t.scan(&uri, 0));
+    REQUIRE(t.id == TID_IDENTIFIER);
+    REQUIRE(t.s == input + 1);         // points into the input, nothing allocated
+    REQUIRE(t.len == 7);
+    REQUIRE(!t.owned);
+    REQUIRE(t.equals("devices"));
+    REQUIRE(t.equals("DEVICES"));
+    REQUIRE(t.equals("Devices", false));
+    REQUIRE(!t.equals("devices", false));
+    REQUIRE(!t.equals("device"));
+    REQUIRE(!t.equals("devices/"));
+
+    REQUIRE(t.scan(&uri, 0));
+    REQUIRE(t.scan(&uri, 0));
+    REQUIRE(t.id == TID_STRING);
+    REQUIRE(t.s == input + 9);
+    REQUIRE(t.len == 15);
+    REQUIRE(!t.owned);
+    REQUIRE(t.equals("colin mackenzie"));
+}
+
+TEST(token_copy_of_view_shares_input)
+{
+    const char* uri = "kitchen";
+    Token t;
+    REQUIRE(t.scan(&uri, 0));
+    Token copy(t);
+    REQUIRE(copy.s == t.s);
+    REQUIRE(copy.len == t.len);
+    REQUIRE(!copy.owned);
+
+    Token assigned;
+    assigned = t;
+    REQUIRE(assigned.s == t.s);
+    REQUIRE(!assigned.owned);
+}
+
+TEST(token_expand_scan_indexes_identifiers)
+{
+    token_init_index();
+    const char* uri = "kitchen/lights";
+    Token t;
+    REQUIRE(t.scan(&uri, 1));
+    REQUIRE(t.id == TID_IDENTIFIER);
+    REQUIRE(t.indexed);
+    REQUIRE(!t.owned);
+    REQUIRE(strcmp(t.s, "kitchen")==0);
+    REQUIRE(binbag_get(Rest::literals_index, (long)t.i) == t.s);
+}
+
+TEST(token_copy_of_allocated_string)
+{
+    Token t;
+    t.set(TID_STRING, "hello world", nullptr);
+    REQUIRE(t.owned);
+    REQUIRE(t.len == 11);
+
+    Token copy(t);
+    REQUIRE(copy.owned);
+    REQUIRE(copy.s != t.s);
+    REQUIRE(strcmp(copy.s, "hello world")==0);
+
+    copy = copy;
+    REQUIRE(strcmp(copy.s, "hello world")==0);
+}
+
+TEST(token_scan_stops_at_end_of_buffer)
+{
+    const char* input = "devices/42";
+    const char* uri = input;
+    Token t;
+    REQUIRE(t.scan(&uri, 0, input + 3));
+    REQUIRE(t.id == TID_IDENTIFIER);
+    REQUIRE(t.len == 3);
+    REQUIRE(t.equals("dev"));
+    REQUIRE(t.hash == Rest::hash_nocase("dev"));
+    REQUIRE(uri == input + 3);
+    REQUIRE(!t.scan(&uri, 0, input + 3));
+    REQUIRE(t.id == TID_EOF);
+
+    // numbers and booleans must not be read past the end either
+    uri = input + 8;
+    REQUIRE(t.scan(&uri, 0, input + 9));
+    REQUIRE(t.id == TID_INTEGER);
+    REQUIRE(t.i == 4);
+    REQUIRE(uri == input + 9);
+
+    const char* flag = "trueish";
+    uri = flag;
+    REQUIRE(t.scan(&uri, 0, flag + 4));
+    REQUIRE(t.id == TID_BOOL);
+    REQUIRE(t.i == 1);
+}
+
+TEST(token_resolve_scan_stops_at_query_string)
+{
+    const char* input = "status?verbose=1";
+    const char* uri = input;
+    Token t;
+    REQUIRE(t.scan(&uri, 0));
+    REQUIRE(t.id == TID_IDENTIFIER);
+    REQUIRE(t.equals("status"));
+    REQUIRE(!t.scan(&uri, 0));
+    REQUIRE(t.id == TID_EOF);
+}
+
+TEST(token_packs_short_words)
+{
+    const char* input = "Status/configuration";
+    const char* uri = input;
+    Token t;
+    REQUIRE(t.scan(&uri, 0));
+    REQUIRE(t.word == Rest::fold_word("status", 6));
+    REQUIRE(t.word != Rest::fold_word("statusx", 7));
+
+    // only the first WORD_INLINE_SIZE characters are packed
+    uri++;
+    REQUIRE(t.scan(&uri, 0));
+    REQUIRE(t.len == 13);
+    REQUIRE(t.word == Rest::fold_word("CONFIGUR", 8));
+}
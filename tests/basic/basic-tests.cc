@@ -2,8 +2,54 @@
 // Created by colin on 5/23/2019.
 //
 
-#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#define CATCH_CONFIG_RUNNER  // we provide main() so the tests of tests/common can be added first
 
 #include <catch.hpp>
 #include <catch_reporter_teamcity.hpp>
 
+#include <string>
+#include <stdio.h>
+
+// from tests/common, tests.h is not included since its TEST, CHECK and FAIL macros clash with Catch
+typedef int (*test_func)();
+void test_each(void (*visit)(const char* name, const char* module, test_func test));
+
+/// \brief Runs a test written with the TEST macro of tests/common as a Catch test case
+class CommonTestInvoker : public Catch::ITestInvoker {
+public:
+    explicit CommonTestInvoker(test_func _test) : test(_test) {}
+
+    void invoke() const override {
+        REQUIRE(test() == 0);   // OK
+    }
+
+private:
+    test_func test;
+};
+
+static void add_common_test(const char* name, const char* module, test_func test)
+{
+    // the test case keeps copies of the name and tags but the invoker is owned by the registry
+    std::string tags = std::string("[") + module + "]";
+    Catch::AutoReg(new CommonTestInvoker(test), Catch::SourceLineInfo(module, 0), Catch::StringRef(),
+            Catch::NameAndTags{ name, tags.c_str() });
+}
+
+int main(int argc, char* argv[])
+{
+    test_each(add_common_test);
+
+    Catch::Session session;
+    int rc = session.applyCommandLine(argc, argv);
+    if(rc != 0)
+        return rc;
+
+    // fail rather than pass when the test named by an add_test() line no longer exists
+    Catch::Config& config = session.config();
+    if(config.testSpec().hasFilters()
+            && Catch::filterTests(Catch::getAllTestCasesSorted(config), config.testSpec(), config).empty()) {
+        fprintf(stderr, "no test cases matched\n");
+        return 2;
+    }
+    return session.run();
+}
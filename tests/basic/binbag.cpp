@@ -6,6 +6,10 @@
 #include <cstring>
 #include <stdio.h>
 #include <binbag.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
 
 #define SAMPLE_L66 "Contrary to popular belief, Lorem Ipsum is not simply random text."
 #define SAMPLE_L97 "It has roots in a piece of classical Latin literature from 45 BC, making it over 2000 years old."
@@ -580,4 +584,319 @@ TEST(binbag_reverse_11)
     return ((bb!=NULL) && binbag_count(bb)==11) ? OK : FAIL;
 }
 
-#endif
\ No newline at end of file
+#endif
+TEST(binbag_index_finds_like_scan)
+{
+    binbag* scan = binbag_split_string(',', SF_IGNORE_EMPTY, SAMPLE_API_WORDS);
+    binbag* indexed = binbag_split_string(',', SF_IGNORE_EMPTY, SAMPLE_API_WORDS);
+    REQUIRE(binbag_index(indexed, BB_INDEX_NOCASE));
+
+    for(auto word: { "api", "Status", "alarm-log", "SYSSTATUS", "missing", "alarm", "alarm-lo", "" }) {
+        INFO(word);
+        REQUIRE(binbag_find_case(indexed, word) == binbag_find_case(scan, word));
+        REQUIRE(binbag_find_nocase(indexed, word) == binbag_find_nocase(scan, word));
+        REQUIRE(binbag_find_nocase_n(indexed, word, 5) == binbag_find_nocase_n(scan, word, 5));
+    }
+
+    // duplicates are found at the lowest ordinal, differing in case only matters to case sensitive lookups
+    long first = binbag_find_case(indexed, "status");
+    long upper = binbag_insert(indexed, "STATUS");
+    REQUIRE(binbag_insert(indexed, "status") > first);
+    REQUIRE(binbag_find_case(indexed, "status") == first);
+    REQUIRE(binbag_find_case(indexed, "STATUS") == upper);
+    REQUIRE(binbag_insert_distinct(indexed, "Status", strcasecmp) == first);
+    REQUIRE(binbag_insert_distinct_n(indexed, "STATUS/1", 6, strncmp) == upper);
+
+    binbag_free(scan);
+    binbag_free(indexed);
+}
+
+TEST(binbag_index_kept_through_resize)
+{
+    char word[32];
+    binbag* bb = binbag_create(32, 1.5);
+    REQUIRE(binbag_index(bb, BB_INDEX_CASE));
+    for(int i=0; i < 500; i++) {
+        sprintf(word, "sensor-%d", i);
+        REQUIRE(binbag_insert_distinct(bb, word, strcmp) == i);
+    }
+    REQUIRE(bb->growths > 0);
+    REQUIRE(bb->index->capacity >= 1000);
+    for(int i=0; i < 500; i++) {
+        sprintf(word, "sensor-%d", i);
+        REQUIRE(binbag_find_case(bb, word) == i);
+    }
+
+    // a case sensitive index cannot serve case insensitive lookups, these still scan
+    REQUIRE(binbag_find_nocase(bb, "SENSOR-42") == 42);
+    REQUIRE(binbag_find_case(bb, "SENSOR-42") == -1);
+
+    binbag_inplace_reverse(bb);
+    REQUIRE(binbag_find_case(bb, "sensor-0") == 499);
+    binbag_free(bb);
+}
+
+TEST(binbag_folded_mode)
+{
+    char word[32];
+    binbag* bb = binbag_create(32, 1.5);
+    REQUIRE(binbag_mode(bb, BB_MODE_FOLDED));
+    REQUIRE(binbag_get_folded(bb, 0) == nullptr);
+    for(int i=0; i < 200; i++) {
+        sprintf(word, "Sensor-%d", i);
+        REQUIRE(binbag_insert(bb, word) == i);
+    }
+    REQUIRE(bb->growths > 0);
+    REQUIRE(binbag_mode(bb, BB_MODE_PLAIN) == 0);     // not empty
+
+    REQUIRE(strcmp(binbag_get(bb, 42), "Sensor-42") == 0);
+    REQUIRE(strcmp(binbag_get_folded(bb, 42), "sensor-42") == 0);
+    REQUIRE(binbag_strlen(bb, 42) == 9);
+    REQUIRE(binbag_strlen(bb, 199) == 10);
+
+    REQUIRE(binbag_find_nocase(bb, "SENSOR-42") == 42);
+    REQUIRE(binbag_find_nocase_n(bb, "sensor-42/status", 9) == 42);
+    REQUIRE(binbag_find_nocase_n(bb, "sensor-4", 9) == -1);
+    REQUIRE(binbag_find_folded_n(bb, "sensor-150", 10) == 150);
+    REQUIRE(binbag_find_folded_n(bb, "sensor-1", 7) == -1);
+    REQUIRE(binbag_find_case(bb, "sensor-42") == -1);
+    REQUIRE(binbag_find_case(bb, "Sensor-42") == 42);
+    REQUIRE(binbag_insert_distinct(bb, "SENSOR-7", strcasecmp) == 7);
+    REQUIRE(binbag_insert_distinct_n(bb, "sensor-7/x", 8, strncasecmp) == 7);
+    REQUIRE(binbag_insertn(bb, "Pump/1", 4) == 200);
+    REQUIRE(strcmp(binbag_get_folded(bb, 200), "pump") == 0);
+
+    // the index gives the same answers
+    REQUIRE(binbag_index(bb, BB_INDEX_NOCASE));
+    REQUIRE(binbag_find_nocase(bb, "SENSOR-42") == 42);
+    REQUIRE(binbag_find_folded_n(bb, "pump", 4) == 200);
+    REQUIRE(binbag_find_folded_n(bb, "sensor-1000", 11) == -1);
+    REQUIRE(binbag_insert_distinct_n(bb, "Valve", 5, strncasecmp) == 201);
+    REQUIRE(binbag_find_nocase(bb, "valve") == 201);
+
+    // sorting keeps the mode
+    binbag* sorted = binbag_sort(bb, binbag_element_sort_asc);
+    REQUIRE(sorted->mode == BB_MODE_FOLDED);
+    REQUIRE(binbag_count(sorted) == 202);
+    REQUIRE(strcmp(binbag_get(sorted, 0), "Pump") == 0);
+    REQUIRE(strcmp(binbag_get_folded(sorted, 201), "valve") == 0);
+    REQUIRE(binbag_find_nocase(sorted, "sensor-0") == 1);
+    binbag_free(sorted);
+    binbag_free(bb);
+}
+
+TEST(binbag_chunked_keeps_pointers)
+{
+    char word[32];
+    std::vector<const char*> pointers;
+    binbag* bb = binbag_create_chunked(64);
+    REQUIRE(binbag_index(bb, BB_INDEX_CASE));
+    REQUIRE(binbag_begin_iterator(bb) == nullptr);
+    for(int i=0; i < 1000; i++) {
+        sprintf(word, "sensor-%d", i);
+        REQUIRE(binbag_insert(bb, word) == i);
+        pointers.push_back(binbag_get(bb, i));
+    }
+    REQUIRE(bb->growths > 0);
+    REQUIRE(binbag_count(bb) == 1000);
+    REQUIRE(binbag_get(bb, 1000) == nullptr);
+    REQUIRE(binbag_resize(bb, 16) == binbag_capacity(bb));
+    REQUIRE(binbag_byte_length(bb) <= binbag_capacity(bb));
+
+    // a string longer than a chunk gets a chunk of its own
+    std::string large(200, 'x');
+    REQUIRE(binbag_insert(bb, large.c_str()) == 1000);
+    REQUIRE(binbag_strlen(bb, 1000) == 200);
+    REQUIRE(binbag_insertn(bb, "pump/1", 4) == 1001);
+
+    for(int i=0; i < 1000; i++) {
+        sprintf(word, "sensor-%d", i);
+        REQUIRE(binbag_get(bb, i) == pointers[i]);
+        REQUIRE(strcmp(pointers[i], word) == 0);
+        REQUIRE(binbag_strlen(bb, i) == (int)strlen(word));
+        REQUIRE(binbag_find_case(bb, word) == i);
+    }
+    REQUIRE(binbag_find_nocase(bb, "SENSOR-500") == 500);
+    REQUIRE(binbag_find_case_n(bb, "pump", 4) == 1001);
+
+    binbag* sorted = binbag_sort(bb, binbag_element_sort_asc);
+    REQUIRE(binbag_count(sorted) == 1002);
+    REQUIRE(strcmp(binbag_get(sorted, 0), "pump") == 0);
+    binbag_free(sorted);
+
+    binbag_inplace_reverse(bb);
+    REQUIRE(binbag_get(bb, 1001 - 7) == pointers[7]);
+    REQUIRE(binbag_find_case(bb, "sensor-7") == 1001 - 7);
+    binbag_free(bb);
+
+    // folded strings in chunks
+    bb = binbag_create_chunked(64);
+    REQUIRE(binbag_mode(bb, BB_MODE_FOLDED));
+    REQUIRE(binbag_index(bb, BB_INDEX_NOCASE));
+    for(int i=0; i < 100; i++) {
+        sprintf(word, "Sensor-%d", i);
+        REQUIRE(binbag_insert_distinct(bb, word, strcasecmp) == i);
+    }
+    REQUIRE(binbag_strlen(bb, 42) == 9);
+    REQUIRE(strcmp(binbag_get_folded(bb, 42), "sensor-42") == 0);
+    REQUIRE(binbag_find_nocase(bb, "SENSOR-42") == 42);
+    binbag_free(bb);
+}
+
+TEST(binbag_chunked_concurrent_readers)
+{
+    const int N = 20000;
+    binbag* bb = binbag_create_chunked(256);
+    REQUIRE(binbag_mode(bb, BB_MODE_FOLDED));
+    REQUIRE(binbag_index(bb, BB_INDEX_NOCASE));
+
+    std::atomic<bool> done(false);
+    std::atomic<long> errors(0);
+    auto reader = [bb,&done,&errors]() {
+        char word[32];
+        while(!done.load()) {
+            long n = (long)binbag_count(bb);
+            for(long i = (n > 200) ? n - 200 : 0; i < n; i++) {
+                sprintf(word, "Sensor-%ld", i);
+                const char* el = binbag_get(bb, i);
+                if(el == nullptr || strcmp(el, word) != 0 || binbag_find_nocase(bb, word) != i)
+                    errors++;
+            }
+        }
+    };
+
+    std::thread r1(reader), r2(reader);
+    char word[32];
+    for(int i=0; i < N; i++) {
+        sprintf(word, "Sensor-%d", i);
+        binbag_insert(bb, word);
+    }
+    done = true;
+    r1.join();
+    r2.join();
+    REQUIRE(errors.load() == 0);
+    REQUIRE(binbag_count(bb) == N);
+    binbag_free(bb);
+}
+
+TEST(binbag_front_coded_finds_like_scan)
+{
+    char word[32], buf[64];
+    binbag* bb = binbag_split_string(',', SF_IGNORE_EMPTY, SAMPLE_API_WORDS);
+    for(auto w: { "temperature", "temperatureOffset", "temperatureHistory", "Status", "status", "" })
+        binbag_insert(bb, w);
+    for(int i=0; i < 100; i++) {
+        sprintf(word, "sensor-%02d", i);
+        binbag_insert(bb, word);
+    }
+    size_t N = binbag_count(bb);
+
+    for(int block_size: { 0, 1, 4, 16 }) for(int flags: { BB_FC_CASE, BB_FC_NOCASE }) {
+        bool nocase = flags == BB_FC_NOCASE;
+        INFO(block_size << (nocase ? " nocase" : " case"));
+        binbag_fc* fc = binbag_fc_create(bb, block_size, flags);
+        REQUIRE(fc != nullptr);
+        REQUIRE(binbag_fc_count(fc) == N - (nocase ? 2 : 1));     // "status" twice, and "Status" in case free
+        REQUIRE(fc->max_length == 18);
+
+        for(size_t i=0; i < N; i++) {
+            const char* w = binbag_get(bb, (long)i);
+            INFO(w);
+            REQUIRE(binbag_fc_find(fc, w, (size_t)-1) == (nocase ? binbag_find_nocase(bb, w) : binbag_find_case(bb, w)));
+        }
+        REQUIRE(binbag_fc_find(fc, "SENSOR-42", (size_t)-1) == (nocase ? binbag_find_nocase(bb, "sensor-42") : -1));
+        REQUIRE(binbag_fc_find(fc, "sensor-42/status", 9) == binbag_find_case(bb, "sensor-42"));
+        for(auto missing: { "sensor-4", "sensor-100", "temperatureOff", "temperatureOffsets", "aaa", "zzz", "alarm-" })
+            REQUIRE(binbag_fc_find(fc, missing, (size_t)-1) == -1);
+
+        // strings come back in sorted order
+        std::string prev;
+        for(long pos=0; pos < (long)binbag_fc_count(fc); pos++) {
+            long len = binbag_fc_get(fc, pos, buf, sizeof(buf));
+            REQUIRE(len == (long)strlen(buf));
+            REQUIRE((pos == 0 || prev < buf));
+            REQUIRE(binbag_fc_find(fc, buf, len) == (long)fc->ordinals[pos]);
+            prev = buf;
+        }
+        REQUIRE(binbag_fc_get(fc, (long)binbag_fc_count(fc), buf, sizeof(buf)) == -1);
+
+        // a short buffer is truncated but still terminated
+        long pos = 0, history = binbag_find_case(bb, "temperatureHistory");
+        while(fc->ordinals[pos] != (uint32_t)history)
+            pos++;
+        REQUIRE(binbag_fc_get(fc, pos, buf, 5) == 18);
+        REQUIRE(strcmp(buf, "temp") == 0);
+
+        if(block_size != 1)
+            REQUIRE(binbag_fc_byte_length(fc) < binbag_byte_length(bb) + N * sizeof(const char*));
+        binbag_fc_free(fc);
+    }
+
+    binbag_fc* empty = binbag_fc_create(binbag_create(16, 1.5), 16, BB_FC_CASE);
+    REQUIRE(binbag_fc_count(empty) == 0);
+    REQUIRE(binbag_fc_find(empty, "api", (size_t)-1) == -1);
+    binbag_fc_free(empty);
+    binbag_free(bb);
+}
+
+// run with: basic-tests "[benchmark]"
+TEST_CASE("binbag_index_benchmark", "[.][benchmark]")
+{
+    char word[32];
+    std::vector<std::string> lookups;
+    for(int i=0; i < 256; i++)
+        lookups.push_back("SENSOR-" + std::to_string(i));
+
+    for(int n: { 2, 4, 8, 16, 32, 64, 256 }) {
+        for(int flags: { BB_INDEX_NONE, BB_INDEX_NOCASE }) for(int mode: { BB_MODE_PLAIN, BB_MODE_FOLDED }) {
+            binbag* bb = binbag_create(128, 1.5);
+            binbag_mode(bb, mode);
+            binbag_index(bb, flags);
+            for(int i=0; i < n; i++) {
+                sprintf(word, "sensor-%d", i);
+                binbag_insert(bb, word);
+            }
+
+            std::string name = std::to_string(n) + " strings, " + ((flags == BB_INDEX_NONE) ? "scan" : "index")
+                    + ((mode == BB_MODE_FOLDED) ? ", folded" : "");
+            long found = 0;
+            BENCHMARK(name) {
+                for(int i=0; i < 100000; i++)
+                    found += binbag_find_nocase(bb, lookups[i % n].c_str());
+            }
+            REQUIRE(found > 0);
+            binbag_free(bb);
+        }
+    }
+}
+
+TEST_CASE("binbag_front_coded_benchmark", "[.][benchmark]")
+{
+    char word[32];
+    std::vector<std::string> lookups;
+    for(int n: { 64, 1024, 16384 }) {
+        binbag* bb = binbag_create(128, 1.5);
+        binbag_index(bb, BB_INDEX_NOCASE);
+        lookups.clear();
+        for(int i=0; i < n; i++) {
+            sprintf(word, "temperatureSensor-%05d", i);
+            binbag_insert(bb, word);
+            lookups.push_back(word);
+        }
+        binbag_fc* fc = binbag_fc_create(bb, 16, BB_FC_NOCASE);
+        WARN(n << " strings, " << binbag_byte_length(bb) + n * sizeof(const char*) << " bytes, front coded " << binbag_fc_byte_length(fc));
+
+        long found = 0;
+        BENCHMARK(std::to_string(n) + " strings, index") {
+            for(int i=0; i < 100000; i++)
+                found += binbag_find_nocase(bb, lookups[(i * 7919) % n].c_str());
+        }
+        BENCHMARK(std::to_string(n) + " strings, front coded") {
+            for(int i=0; i < 100000; i++)
+                found += binbag_fc_find(fc, lookups[(i * 7919) % n].c_str(), (size_t)-1);
+        }
+        REQUIRE(found > 0);
+        binbag_fc_free(fc);
+        binbag_free(bb);
+    }
+}
@@ -107,3 +107,43 @@ TEST(paged_pool_array_fifty_objects)
            ? OK
            : FAIL;
 }
+
+TEST(paged_pool_allocate_aligned)
+{
+    Rest::PagedPool pool(64);
+    void* c = pool.allocate(3, 1);
+    void* d = pool.allocate(sizeof(double), alignof(double));
+    return (c != nullptr && d != nullptr && ((size_t)d % alignof(double))==0)
+           ? OK
+           : FAIL;
+}
+
+TEST(paged_pool_make_aligned)
+{
+    Rest::PagedPool pool(64);
+    uint16_t* ids = pool.makeArray<uint16_t>(3, 0);
+    double* d = pool.make<double>(1.5);
+    void** p = pool.makeArray<void*>(2, nullptr);
+    return (ids != nullptr && d != nullptr && p != nullptr
+            && ((size_t)d % alignof(double))==0 && ((size_t)p % alignof(void*))==0 && *d == 1.5)
+           ? OK
+           : FAIL;
+}
+
+TEST(paged_pool_reset)
+{
+    Rest::PagedPool pool(64);
+    paged_pool_add_n(pool, 50);
+    auto before = pool.info();
+    pool.reset();
+    auto info = pool.info();
+
+    // pages are combined into one page that fits everything that was allocated before
+    if(before.count < 2 || info.count != 1 || info.bytes != 0 || info.capacity != before.capacity)
+        return FAIL;
+
+    paged_pool_add_n(pool, 50);
+    return (pool.info().count == 1)
+           ? OK
+           : FAIL;
+}
@@ -161,6 +161,12 @@ void test_all()
     }
 }
 
+void test_each(void (*visit)(const char* name, const char* module, test_func test))
+{
+    for(Test* t = head_test; t != NULL && t < tail_test; t++)
+        visit(t->name, t->module, t->test);
+}
+
 int test_by_name(const char* name)
 {
     int tested=0;
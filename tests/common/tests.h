@@ -34,6 +34,9 @@ void test_add(Test test);
 
 void test_all();
 
+// call visit for every registered test, used to hand the tests to another test runner
+void test_each(void (*visit)(const char* name, const char* module, test_func test));
+
 int report(const char* testname, int result);
 
 #ifdef __cplusplus